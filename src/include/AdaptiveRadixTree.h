@@ -0,0 +1,688 @@
+#ifndef ADAPTIVE_RADIX_TREE_H
+#define ADAPTIVE_RADIX_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace art_detail {
+
+/*
+ * Binary-comparable key encodings: comparing the bytes lexicographically
+ * gives the order of the keys. Integers are stored big-endian with the sign
+ * bit flipped; strings use their bytes plus the terminating NUL, which keeps
+ * the key set prefix-free (strings must not contain NUL themselves).
+ */
+template <typename Key, class Enable = void>
+struct KeyTraits;
+
+template <typename Key>
+struct KeyTraits<Key, typename std::enable_if<std::is_integral<Key>::value>::type> {
+    struct Bytes {
+        uint8_t data[sizeof(Key)];
+
+        std::size_t size() const {
+            return sizeof(Key);
+        }
+
+        uint8_t operator[](std::size_t i) const {
+            return data[i];
+        }
+    };
+
+    static Bytes encode(const Key& key) {
+        typedef typename std::make_unsigned<Key>::type Unsigned;
+        Unsigned bits = Unsigned(key);
+        if (std::is_signed<Key>::value) {
+            bits ^= Unsigned(Unsigned(1) << (8 * sizeof(Key) - 1));
+        }
+        Bytes bytes;
+        for (std::size_t i = sizeof(Key); i-- > 0;) {
+            bytes.data[i] = uint8_t(bits);
+            bits = Unsigned(bits >> 7 >> 1);
+        }
+        return bytes;
+    }
+};
+
+template <>
+struct KeyTraits<std::string> {
+    struct Bytes {
+        const uint8_t* data;
+        std::size_t length;
+
+        std::size_t size() const {
+            return length;
+        }
+
+        uint8_t operator[](std::size_t i) const {
+            return data[i];
+        }
+    };
+
+    static Bytes encode(const std::string& key) {
+        Bytes bytes;
+        bytes.data = reinterpret_cast<const uint8_t*>(key.c_str());
+        bytes.length = key.size() + 1;
+        return bytes;
+    }
+};
+
+} // namespace art_detail
+
+/*
+ * Adaptive radix tree (Leis et al., "The Adaptive Radix Tree: ARTful
+ * Indexing for Main-Memory Databases").
+ *
+ * Keys are split into bytes of their binary-comparable encoding, one byte per
+ * tree level. Inner nodes grow through four layouts as their fan-out
+ * increases:
+ *
+ *   Node4   up to 4 sorted key bytes and children
+ *   Node16  up to 16 sorted key bytes, searched with one SSE2 comparison
+ *   Node48  256-entry byte index into 48 children
+ *   Node256 256 children indexed directly by the byte
+ *
+ * Path compression stores the bytes shared by every key below a node in the
+ * node itself (up to MAX_PREFIX bytes, longer prefixes are checked at the
+ * leaf), and leaves are tagged pointers to the full key and value, so chains
+ * of single-child nodes never exist.
+ *
+ * Traversal is in key order, which gives ordered range scans.
+ */
+template <typename Key, typename Value>
+class AdaptiveRadixTree {
+    typedef art_detail::KeyTraits<Key> Traits;
+    typedef typename Traits::Bytes Bytes;
+
+public:
+    struct Stats {
+        std::size_t node4;
+        std::size_t node16;
+        std::size_t node48;
+        std::size_t node256;
+        std::size_t leaves;
+        std::size_t memoryBytes;
+    };
+
+    AdaptiveRadixTree() : root_(nullptr), size_(0) {}
+
+    AdaptiveRadixTree(const AdaptiveRadixTree&) = delete;
+    AdaptiveRadixTree& operator=(const AdaptiveRadixTree&) = delete;
+
+    ~AdaptiveRadixTree() {
+        destroy(root_);
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    const Value* find(const Key& key) const {
+        const Bytes bytes = Traits::encode(key);
+        const Node* node = root_;
+        std::size_t depth = 0;
+        while (node != nullptr) {
+            if (isLeaf(node)) {
+                const Leaf* leaf = asLeaf(node);
+                return leaf->key == key ? &leaf->value : nullptr;
+            }
+            if (node->prefixLength != 0) {
+                const std::size_t stored = std::min<std::size_t>(node->prefixLength, MAX_PREFIX);
+                for (std::size_t i = 0; i < stored; i++) {
+                    if (depth + i >= bytes.size() || node->prefix[i] != bytes[depth + i]) {
+                        return nullptr;
+                    }
+                }
+                // Bytes past MAX_PREFIX are skipped, the leaf comparison checks them
+                depth += node->prefixLength;
+            }
+            if (depth >= bytes.size()) {
+                return nullptr;
+            }
+            node = findChild(node, bytes[depth]);
+            depth++;
+        }
+        return nullptr;
+    }
+
+    // Insert key or overwrite its value.
+    void insert(const Key& key, const Value& value) {
+        insert(root_, key, Traits::encode(key), 0, value);
+    }
+
+    // Visit all pairs with lo <= key <= hi in key order, return the number visited
+    template <class Visitor>
+    std::size_t scan(const Key& lo, const Key& hi, Visitor visitor) const {
+        if (root_ == nullptr || hi < lo) {
+            return 0;
+        }
+        ScanBounds bounds = {Traits::encode(lo), Traits::encode(hi), lo, hi};
+        return scan(root_, 0, bounds, true, true, visitor);
+    }
+
+    Stats stats() const {
+        Stats result = {0, 0, 0, 0, 0, 0};
+        collectStats(root_, result);
+        return result;
+    }
+
+private:
+    static constexpr std::size_t MAX_PREFIX = 8;
+
+    enum NodeType : uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+    struct Node {
+        NodeType type;
+        uint16_t count;
+        uint32_t prefixLength;
+        uint8_t prefix[MAX_PREFIX];
+
+        explicit Node(NodeType type_) : type(type_), count(0), prefixLength(0) {}
+    };
+
+    struct Node4 : Node {
+        uint8_t keys[4];
+        Node* children[4];
+
+        Node4() : Node(NODE4) {}
+    };
+
+    struct Node16 : Node {
+        uint8_t keys[16];
+        Node* children[16];
+
+        Node16() : Node(NODE16) {}
+    };
+
+    struct Node48 : Node {
+        // childIndex[byte] is the child slot + 1, 0 when the byte has no child
+        uint8_t childIndex[256];
+        Node* children[48];
+
+        Node48() : Node(NODE48) {
+            std::memset(childIndex, 0, sizeof(childIndex));
+        }
+    };
+
+    struct Node256 : Node {
+        Node* children[256];
+
+        Node256() : Node(NODE256) {
+            std::fill(children, children + 256, nullptr);
+        }
+    };
+
+    struct Leaf {
+        Key key;
+        Value value;
+    };
+
+    struct ScanBounds {
+        Bytes loBytes;
+        Bytes hiBytes;
+        Key lo;
+        Key hi;
+    };
+
+    // Leaves are tagged with the low pointer bit
+    static bool isLeaf(const Node* node) {
+        return (reinterpret_cast<uintptr_t>(node) & 1) != 0;
+    }
+
+    static Node* makeLeaf(Leaf* leaf) {
+        return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(leaf) | 1);
+    }
+
+    static Leaf* asLeaf(const Node* node) {
+        return reinterpret_cast<Leaf*>(reinterpret_cast<uintptr_t>(node) & ~uintptr_t(1));
+    }
+
+    static Node* const* findChildSlot(const Node* node, uint8_t byte) {
+        switch (node->type) {
+        case NODE4: {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == byte) {
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case NODE16: {
+            const Node16* n = static_cast<const Node16*>(node);
+#if defined(__SSE2__)
+            const __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8(char(byte)),
+                                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+            const int mask = _mm_movemask_epi8(matches) & ((1 << n->count) - 1);
+            return mask != 0 ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+            for (std::size_t i = 0; i < n->count; i++) {
+                if (n->keys[i] == byte) {
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+#endif
+        }
+        case NODE48: {
+            const Node48* n = static_cast<const Node48*>(node);
+            return n->childIndex[byte] != 0 ? &n->children[n->childIndex[byte] - 1] : nullptr;
+        }
+        case NODE256: {
+            const Node256* n = static_cast<const Node256*>(node);
+            return n->children[byte] != nullptr ? &n->children[byte] : nullptr;
+        }
+        }
+        return nullptr;
+    }
+
+    static const Node* findChild(const Node* node, uint8_t byte) {
+        Node* const* slot = findChildSlot(node, byte);
+        return slot != nullptr ? *slot : nullptr;
+    }
+
+    static Node** findChildSlot(Node* node, uint8_t byte) {
+        return const_cast<Node**>(findChildSlot(static_cast<const Node*>(node), byte));
+    }
+
+    // Any leaf below node, its key gives the prefix bytes beyond MAX_PREFIX
+    static const Leaf* minimumLeaf(const Node* node) {
+        while (!isLeaf(node)) {
+            switch (node->type) {
+            case NODE4:
+                node = static_cast<const Node4*>(node)->children[0];
+                break;
+            case NODE16:
+                node = static_cast<const Node16*>(node)->children[0];
+                break;
+            case NODE48: {
+                const Node48* n = static_cast<const Node48*>(node);
+                std::size_t byte = 0;
+                while (n->childIndex[byte] == 0) {
+                    byte++;
+                }
+                node = n->children[n->childIndex[byte] - 1];
+                break;
+            }
+            case NODE256: {
+                const Node256* n = static_cast<const Node256*>(node);
+                std::size_t byte = 0;
+                while (n->children[byte] == nullptr) {
+                    byte++;
+                }
+                node = n->children[byte];
+                break;
+            }
+            }
+        }
+        return asLeaf(node);
+    }
+
+    // Byte i of the compressed path of node, which starts at depth
+    static uint8_t prefixByte(const Node* node, std::size_t depth, std::size_t i) {
+        if (i < MAX_PREFIX) {
+            return node->prefix[i];
+        }
+        return Traits::encode(minimumLeaf(node)->key)[depth + i];
+    }
+
+    // Number of leading bytes of the compressed path of node matching bytes
+    static std::size_t prefixMismatch(const Node* node, const Bytes& bytes, std::size_t depth) {
+        std::size_t i = 0;
+        while (i < node->prefixLength && depth + i < bytes.size() && prefixByte(node, depth, i) == bytes[depth + i]) {
+            i++;
+        }
+        return i;
+    }
+
+    void insert(Node*& slot, const Key& key, const Bytes& bytes, std::size_t depth, const Value& value) {
+        if (slot == nullptr) {
+            slot = makeLeaf(new Leaf{key, value});
+            size_++;
+            return;
+        }
+
+        if (isLeaf(slot)) {
+            Leaf* existing = asLeaf(slot);
+            if (existing->key == key) {
+                existing->value = value;
+                return;
+            }
+            // Split the leaf: a Node4 holding the common bytes and both leaves
+            const Bytes existingBytes = Traits::encode(existing->key);
+            std::size_t common = 0;
+            while (existingBytes[depth + common] == bytes[depth + common]) {
+                common++;
+            }
+            Node4* node = new Node4();
+            setPrefix(node, bytes, depth, common);
+            addChild4(node, existingBytes[depth + common], slot);
+            addChild4(node, bytes[depth + common], makeLeaf(new Leaf{key, value}));
+            slot = node;
+            size_++;
+            return;
+        }
+
+        Node* node = slot;
+        if (node->prefixLength != 0) {
+            const std::size_t mismatch = prefixMismatch(node, bytes, depth);
+            if (mismatch < node->prefixLength) {
+                // The key leaves the compressed path: split it at the mismatch
+                Node4* parent = new Node4();
+                setPrefix(parent, bytes, depth, mismatch);
+                const uint8_t nodeByte = prefixByte(node, depth, mismatch);
+                shortenPrefix(node, depth, mismatch + 1);
+                addChild4(parent, nodeByte, node);
+                addChild4(parent, bytes[depth + mismatch], makeLeaf(new Leaf{key, value}));
+                slot = parent;
+                size_++;
+                return;
+            }
+            depth += node->prefixLength;
+        }
+
+        Node** child = findChildSlot(node, bytes[depth]);
+        if (child != nullptr) {
+            insert(*child, key, bytes, depth + 1, value);
+            return;
+        }
+        addChild(slot, bytes[depth], makeLeaf(new Leaf{key, value}));
+        size_++;
+    }
+
+    static void setPrefix(Node* node, const Bytes& bytes, std::size_t depth, std::size_t length) {
+        node->prefixLength = uint32_t(length);
+        for (std::size_t i = 0; i < std::min<std::size_t>(length, MAX_PREFIX); i++) {
+            node->prefix[i] = bytes[depth + i];
+        }
+    }
+
+    // Drop the first n bytes of the compressed path of node, which starts at depth
+    static void shortenPrefix(Node* node, std::size_t depth, std::size_t n) {
+        const std::size_t length = node->prefixLength - n;
+        uint8_t shifted[MAX_PREFIX];
+        for (std::size_t i = 0; i < std::min<std::size_t>(length, MAX_PREFIX); i++) {
+            shifted[i] = prefixByte(node, depth, n + i);
+        }
+        std::memcpy(node->prefix, shifted, std::min<std::size_t>(length, MAX_PREFIX));
+        node->prefixLength = uint32_t(length);
+    }
+
+    static void copyHeader(Node* to, const Node* from) {
+        to->count = from->count;
+        to->prefixLength = from->prefixLength;
+        std::memcpy(to->prefix, from->prefix, MAX_PREFIX);
+    }
+
+    // Insert into sorted key/child arrays of a Node4 or Node16 with room left
+    template <class SmallNode>
+    static void insertSorted(SmallNode* node, uint8_t byte, Node* child) {
+        std::size_t pos = 0;
+        while (pos < node->count && node->keys[pos] < byte) {
+            pos++;
+        }
+        std::memmove(node->keys + pos + 1, node->keys + pos, node->count - pos);
+        std::memmove(node->children + pos + 1, node->children + pos, (node->count - pos) * sizeof(Node*));
+        node->keys[pos] = byte;
+        node->children[pos] = child;
+        node->count++;
+    }
+
+    static void addChild4(Node4* node, uint8_t byte, Node* child) {
+        insertSorted(node, byte, child);
+    }
+
+    // Add a child under a byte not present yet, growing the node if it is full
+    static void addChild(Node*& slot, uint8_t byte, Node* child) {
+        Node* node = slot;
+        switch (node->type) {
+        case NODE4: {
+            Node4* n = static_cast<Node4*>(node);
+            if (n->count < 4) {
+                insertSorted(n, byte, child);
+                return;
+            }
+            Node16* grown = new Node16();
+            copyHeader(grown, n);
+            std::memcpy(grown->keys, n->keys, 4);
+            std::memcpy(grown->children, n->children, 4 * sizeof(Node*));
+            insertSorted(grown, byte, child);
+            slot = grown;
+            delete n;
+            return;
+        }
+        case NODE16: {
+            Node16* n = static_cast<Node16*>(node);
+            if (n->count < 16) {
+                insertSorted(n, byte, child);
+                return;
+            }
+            Node48* grown = new Node48();
+            copyHeader(grown, n);
+            for (std::size_t i = 0; i < 16; i++) {
+                grown->childIndex[n->keys[i]] = uint8_t(i + 1);
+                grown->children[i] = n->children[i];
+            }
+            grown->childIndex[byte] = 17;
+            grown->children[16] = child;
+            grown->count = 17;
+            slot = grown;
+            delete n;
+            return;
+        }
+        case NODE48: {
+            Node48* n = static_cast<Node48*>(node);
+            if (n->count < 48) {
+                n->children[n->count] = child;
+                n->childIndex[byte] = uint8_t(n->count + 1);
+                n->count++;
+                return;
+            }
+            Node256* grown = new Node256();
+            copyHeader(grown, n);
+            for (std::size_t b = 0; b < 256; b++) {
+                if (n->childIndex[b] != 0) {
+                    grown->children[b] = n->children[n->childIndex[b] - 1];
+                }
+            }
+            grown->children[byte] = child;
+            grown->count = 49;
+            slot = grown;
+            delete n;
+            return;
+        }
+        case NODE256: {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[byte] = child;
+            n->count++;
+            return;
+        }
+        }
+    }
+
+    /*
+     * In-order traversal restricted to [lo, hi]. loActive (hiActive) means the
+     * path so far equals the first bytes of lo (hi), so children below the
+     * bound byte can be skipped; once the path is strictly inside the range the
+     * bound no longer applies to the subtree.
+     */
+    template <class Visitor>
+    std::size_t scan(const Node* node, std::size_t depth, const ScanBounds& bounds, bool loActive, bool hiActive,
+                     Visitor& visitor) const {
+        if (isLeaf(node)) {
+            const Leaf* leaf = asLeaf(node);
+            if (leaf->key < bounds.lo || bounds.hi < leaf->key) {
+                return 0;
+            }
+            visitor(leaf->key, leaf->value);
+            return 1;
+        }
+
+        for (std::size_t i = 0; i < node->prefixLength && (loActive || hiActive); i++) {
+            const uint8_t byte = prefixByte(node, depth, i);
+            if (loActive) {
+                if (depth + i >= bounds.loBytes.size() || byte > bounds.loBytes[depth + i]) {
+                    loActive = false;
+                } else if (byte < bounds.loBytes[depth + i]) {
+                    return 0;
+                }
+            }
+            if (hiActive) {
+                if (depth + i >= bounds.hiBytes.size() || byte > bounds.hiBytes[depth + i]) {
+                    return 0;
+                } else if (byte < bounds.hiBytes[depth + i]) {
+                    hiActive = false;
+                }
+            }
+        }
+        depth += node->prefixLength;
+
+        const int loByte = loActive && depth < bounds.loBytes.size() ? bounds.loBytes[depth] : -1;
+        const int hiByte = hiActive && depth < bounds.hiBytes.size() ? bounds.hiBytes[depth] : 256;
+        std::size_t visited = 0;
+        auto visitChild = [&](int byte, const Node* child) {
+            if (byte >= loByte && byte <= hiByte) {
+                visited += scan(child, depth + 1, bounds, byte == loByte, byte == hiByte, visitor);
+            }
+        };
+        switch (node->type) {
+        case NODE4: {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                visitChild(n->keys[i], n->children[i]);
+            }
+            break;
+        }
+        case NODE16: {
+            const Node16* n = static_cast<const Node16*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                visitChild(n->keys[i], n->children[i]);
+            }
+            break;
+        }
+        case NODE48: {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (int byte = std::max(loByte, 0); byte <= std::min(hiByte, 255); byte++) {
+                if (n->childIndex[byte] != 0) {
+                    visitChild(byte, n->children[n->childIndex[byte] - 1]);
+                }
+            }
+            break;
+        }
+        case NODE256: {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (int byte = std::max(loByte, 0); byte <= std::min(hiByte, 255); byte++) {
+                if (n->children[byte] != nullptr) {
+                    visitChild(byte, n->children[byte]);
+                }
+            }
+            break;
+        }
+        }
+        return visited;
+    }
+
+    static void collectStats(const Node* node, Stats& stats) {
+        if (node == nullptr) {
+            return;
+        }
+        if (isLeaf(node)) {
+            stats.leaves++;
+            stats.memoryBytes += sizeof(Leaf);
+            return;
+        }
+        forEachChild(node, [&](const Node* child) { collectStats(child, stats); });
+        switch (node->type) {
+        case NODE4:
+            stats.node4++;
+            stats.memoryBytes += sizeof(Node4);
+            break;
+        case NODE16:
+            stats.node16++;
+            stats.memoryBytes += sizeof(Node16);
+            break;
+        case NODE48:
+            stats.node48++;
+            stats.memoryBytes += sizeof(Node48);
+            break;
+        case NODE256:
+            stats.node256++;
+            stats.memoryBytes += sizeof(Node256);
+            break;
+        }
+    }
+
+    template <class Function>
+    static void forEachChild(const Node* node, Function function) {
+        switch (node->type) {
+        case NODE4: {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                function(n->children[i]);
+            }
+            break;
+        }
+        case NODE16: {
+            const Node16* n = static_cast<const Node16*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                function(n->children[i]);
+            }
+            break;
+        }
+        case NODE48: {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (std::size_t i = 0; i < n->count; i++) {
+                function(n->children[i]);
+            }
+            break;
+        }
+        case NODE256: {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (std::size_t byte = 0; byte < 256; byte++) {
+                if (n->children[byte] != nullptr) {
+                    function(n->children[byte]);
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    static void destroy(Node* node) {
+        if (node == nullptr) {
+            return;
+        }
+        if (isLeaf(node)) {
+            delete asLeaf(node);
+            return;
+        }
+        forEachChild(node, [](const Node* child) { destroy(const_cast<Node*>(child)); });
+        switch (node->type) {
+        case NODE4:
+            delete static_cast<Node4*>(node);
+            break;
+        case NODE16:
+            delete static_cast<Node16*>(node);
+            break;
+        case NODE48:
+            delete static_cast<Node48*>(node);
+            break;
+        case NODE256:
+            delete static_cast<Node256*>(node);
+            break;
+        }
+    }
+
+    Node* root_;
+    std::size_t size_;
+};
+
+#endif
@@ -0,0 +1,542 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Cache-conscious B+tree.
+ *
+ * Every node occupies exactly NodeBytes bytes and is allocated on a NodeBytes
+ * boundary (capped at a page), so a 64/256 byte node spans whole cache lines
+ * and a 4096 byte node spans exactly one page. Keys and values of a leaf are
+ * stored in separate arrays so the intra-node search only touches key lines.
+ *
+ * Inner node layout: keys[i] is the smallest key of children[i + 1], i.e.
+ * children[i] holds keys < keys[i] and children[i + 1] holds keys >= keys[i].
+ */
+namespace bptree_detail {
+
+inline void* alignedAllocate(std::size_t alignment, std::size_t size) {
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+inline void alignedFree(void* ptr) {
+    free(ptr);
+}
+
+// Number of keys in keys[0, n) that are strictly lower than key.
+template <typename Key>
+inline std::size_t countLess(const Key* keys, std::size_t n, const Key& key) {
+    return std::lower_bound(keys, keys + n, key) - keys;
+}
+
+// Number of keys in keys[0, n) that are lower or equal to key.
+template <typename Key>
+inline std::size_t countLessEqual(const Key* keys, std::size_t n, const Key& key) {
+    return std::upper_bound(keys, keys + n, key) - keys;
+}
+
+#if defined(__SSE2__)
+/*
+ * 32-bit integer keys are searched with a SIMD scan. A node can hold hundreds
+ * of keys when it is page sized, so the range is first narrowed with a binary
+ * search until it fits a few vectors, then the remaining keys are compared in
+ * parallel and the matching lanes counted.
+ */
+static const std::size_t SIMD_SCAN_WINDOW = 32;
+
+template <bool OrEqual>
+inline std::size_t simdCount(const int32_t* keys, std::size_t n, int32_t key) {
+    std::size_t lo = 0;
+    std::size_t hi = n;
+    while (hi - lo > SIMD_SCAN_WINDOW) {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (OrEqual ? keys[mid] <= key : keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    std::size_t count = lo;
+    std::size_t i = lo;
+#if defined(__AVX2__)
+    const __m256i needle8 = _mm256_set1_epi32(key);
+    for (; i + 8 <= hi; i += 8) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        const __m256i less = _mm256_cmpgt_epi32(needle8, block);
+        const __m256i counted = OrEqual ? _mm256_or_si256(less, _mm256_cmpeq_epi32(block, needle8)) : less;
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(counted));
+        if (mask != 0xFF) {
+            return count + __builtin_ctz(~mask);
+        }
+        count += 8;
+    }
+#endif
+    const __m128i needle = _mm_set1_epi32(key);
+    for (; i + 4 <= hi; i += 4) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        const __m128i less = _mm_cmplt_epi32(block, needle);
+        const __m128i counted = OrEqual ? _mm_or_si128(less, _mm_cmpeq_epi32(block, needle)) : less;
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(counted));
+        if (mask != 0xF) {
+            // keys are sorted, the counted lanes are a prefix of the block
+            return count + __builtin_ctz(~mask);
+        }
+        count += 4;
+    }
+    for (; i < hi; i++) {
+        if (OrEqual ? keys[i] > key : keys[i] >= key) {
+            return count;
+        }
+        count++;
+    }
+    return count;
+}
+
+inline std::size_t countLess(const int32_t* keys, std::size_t n, const int32_t& key) {
+    return simdCount<false>(keys, n, key);
+}
+
+inline std::size_t countLessEqual(const int32_t* keys, std::size_t n, const int32_t& key) {
+    return simdCount<true>(keys, n, key);
+}
+#endif
+
+} // namespace bptree_detail
+
+template <typename Key, typename Value, std::size_t NodeBytes = 256>
+class BPlusTree {
+    struct NodeHeader {
+        uint32_t count;
+        uint32_t isLeaf;
+    };
+
+public:
+    static const std::size_t LEAF_CAPACITY =
+        (NodeBytes - sizeof(NodeHeader) - sizeof(void*)) / (sizeof(Key) + sizeof(Value));
+    static const std::size_t INNER_CAPACITY =
+        (NodeBytes - sizeof(NodeHeader) - sizeof(void*)) / (sizeof(Key) + sizeof(void*));
+
+    static_assert(LEAF_CAPACITY >= 4, "NodeBytes is too small for the key/value types.");
+    static_assert(INNER_CAPACITY >= 4, "NodeBytes is too small for the key type.");
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "BPlusTree stores keys and values in raw node arrays.");
+
+    struct Stats {
+        std::size_t height;
+        std::size_t innerNodes;
+        std::size_t leafNodes;
+        std::size_t memoryBytes;
+    };
+
+private:
+    struct LeafNode {
+        NodeHeader header;
+        Key keys[LEAF_CAPACITY];
+        Value values[LEAF_CAPACITY];
+        LeafNode* next;
+    };
+
+    struct InnerNode {
+        NodeHeader header;
+        Key keys[INNER_CAPACITY];
+        NodeHeader* children[INNER_CAPACITY + 1];
+    };
+
+    static_assert(sizeof(LeafNode) <= NodeBytes, "Leaf node does not fit NodeBytes.");
+    static_assert(sizeof(InnerNode) <= NodeBytes, "Inner node does not fit NodeBytes.");
+
+    static const std::size_t NODE_ALIGNMENT = NodeBytes < 4096 ? NodeBytes : 4096;
+
+public:
+    BPlusTree() : root_(nullptr), firstLeaf_(nullptr), size_(0), height_(0), innerNodes_(0), leafNodes_(0) {}
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    ~BPlusTree() {
+        clear();
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    void clear() {
+        if (root_ != nullptr) {
+            freeSubtree(root_);
+        }
+        root_ = nullptr;
+        firstLeaf_ = nullptr;
+        size_ = 0;
+        height_ = 0;
+        innerNodes_ = 0;
+        leafNodes_ = 0;
+    }
+
+    // Return a pointer to the value of key, nullptr if the key is absent.
+    const Value* find(const Key& key) const {
+        if (root_ == nullptr) {
+            return nullptr;
+        }
+        return findInLeaf(&findLeaf(key)->header, key);
+    }
+
+    /*
+     * The lookup of find() one node at a time, for callers interleaving
+     * several lookups (InterleavedLookup.h): start at rootNode(), follow
+     * childFor() while the node is not a leaf and finish with findInLeaf().
+     * Each call reads only the node it is given, so that node can be
+     * prefetched before the call. rootNode() is nullptr for an empty tree.
+     */
+    typedef const NodeHeader* NodeHandle;
+
+    NodeHandle rootNode() const {
+        return root_;
+    }
+
+    static bool isLeaf(NodeHandle node) {
+        return node->isLeaf != 0;
+    }
+
+    static NodeHandle childFor(NodeHandle node, const Key& key) {
+        const InnerNode* inner = asInner(node);
+        return inner->children[bptree_detail::countLessEqual(inner->keys, inner->header.count, key)];
+    }
+
+    static const Value* findInLeaf(NodeHandle node, const Key& key) {
+        const LeafNode* leaf = asLeaf(node);
+        const std::size_t pos = bptree_detail::countLess(leaf->keys, leaf->header.count, key);
+        if (pos < leaf->header.count && leaf->keys[pos] == key) {
+            return &leaf->values[pos];
+        }
+        return nullptr;
+    }
+
+    // Insert key or overwrite its value. Return true if the key was new.
+    bool insert(const Key& key, const Value& value) {
+        if (root_ == nullptr) {
+            LeafNode* leaf = newLeaf();
+            root_ = &leaf->header;
+            firstLeaf_ = leaf;
+            height_ = 1;
+        }
+
+        InnerNode* path[MAX_HEIGHT];
+        std::size_t slots[MAX_HEIGHT];
+        std::size_t depth = 0;
+        NodeHeader* node = root_;
+        while (!node->isLeaf) {
+            InnerNode* inner = asInner(node);
+            const std::size_t slot = bptree_detail::countLessEqual(inner->keys, inner->header.count, key);
+            path[depth] = inner;
+            slots[depth] = slot;
+            depth++;
+            node = inner->children[slot];
+        }
+
+        LeafNode* leaf = asLeaf(node);
+        std::size_t pos = bptree_detail::countLess(leaf->keys, leaf->header.count, key);
+        if (pos < leaf->header.count && leaf->keys[pos] == key) {
+            leaf->values[pos] = value;
+            return false;
+        }
+
+        if (leaf->header.count < LEAF_CAPACITY) {
+            insertInLeaf(leaf, pos, key, value);
+            size_++;
+            return true;
+        }
+
+        // Split the full leaf in two halves and push the separator upward.
+        LeafNode* right = newLeaf();
+        const std::size_t half = LEAF_CAPACITY / 2;
+        right->header.count = uint32_t(LEAF_CAPACITY - half);
+        std::copy(leaf->keys + half, leaf->keys + LEAF_CAPACITY, right->keys);
+        std::copy(leaf->values + half, leaf->values + LEAF_CAPACITY, right->values);
+        leaf->header.count = uint32_t(half);
+        right->next = leaf->next;
+        leaf->next = right;
+
+        if (pos <= half) {
+            insertInLeaf(leaf, pos, key, value);
+        } else {
+            insertInLeaf(right, pos - half, key, value);
+        }
+        size_++;
+
+        Key separator = right->keys[0];
+        NodeHeader* newChild = &right->header;
+        while (depth > 0) {
+            depth--;
+            InnerNode* parent = path[depth];
+            const std::size_t slot = slots[depth];
+            if (parent->header.count < INNER_CAPACITY) {
+                insertInInner(parent, slot, separator, newChild);
+                return true;
+            }
+            splitInner(parent, slot, separator, newChild);
+        }
+
+        // The root was split, grow the tree by one level.
+        InnerNode* newRoot = newInner();
+        newRoot->header.count = 1;
+        newRoot->keys[0] = separator;
+        newRoot->children[0] = root_;
+        newRoot->children[1] = newChild;
+        root_ = &newRoot->header;
+        height_++;
+        return true;
+    }
+
+    /*
+     * Build the tree from the given pairs in one pass instead of one insert
+     * per key: pairs are sorted, leaves are packed to fillFactor and the inner
+     * levels are built bottom-up. The tree must be empty. If a key appears
+     * several times the last value wins, like repeated inserts would.
+     */
+    void bulkLoad(const std::vector<Key>& keys, const std::vector<Value>& values, double fillFactor = 1.0) {
+        clear();
+        if (keys.empty()) {
+            return;
+        }
+
+        std::vector<std::size_t> order(keys.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+
+        const std::size_t leafCapacity = LEAF_CAPACITY;
+        const std::size_t innerCapacity = INNER_CAPACITY;
+        const std::size_t leafFill =
+            std::max<std::size_t>(1, std::min(leafCapacity, std::size_t(leafCapacity * fillFactor)));
+        const std::size_t innerFill =
+            std::max<std::size_t>(2, std::min(innerCapacity, std::size_t(innerCapacity * fillFactor)));
+
+        std::vector<NodeHeader*> level;
+        std::vector<Key> lowKeys;
+        LeafNode* leaf = nullptr;
+        LeafNode* previous = nullptr;
+        for (std::size_t i = 0; i < order.size(); i++) {
+            const Key& key = keys[order[i]];
+            const Value& value = values[order[i]];
+            if (leaf != nullptr && leaf->header.count > 0 && leaf->keys[leaf->header.count - 1] == key) {
+                leaf->values[leaf->header.count - 1] = value;
+                continue;
+            }
+            if (leaf == nullptr || leaf->header.count == leafFill) {
+                leaf = newLeaf();
+                if (previous != nullptr) {
+                    previous->next = leaf;
+                } else {
+                    firstLeaf_ = leaf;
+                }
+                previous = leaf;
+                level.push_back(&leaf->header);
+                lowKeys.push_back(key);
+            }
+            leaf->keys[leaf->header.count] = key;
+            leaf->values[leaf->header.count] = value;
+            leaf->header.count++;
+            size_++;
+        }
+        height_ = 1;
+
+        while (level.size() > 1) {
+            std::vector<NodeHeader*> parents;
+            std::vector<Key> parentLowKeys;
+            for (std::size_t i = 0; i < level.size();) {
+                // A node needs at least two children, never leave a single orphan at the end.
+                std::size_t take = std::min(innerFill + 1, level.size() - i);
+                if (level.size() - i - take == 1) {
+                    take--;
+                }
+                InnerNode* inner = newInner();
+                inner->children[0] = level[i];
+                for (std::size_t c = 1; c < take; c++) {
+                    inner->keys[c - 1] = lowKeys[i + c];
+                    inner->children[c] = level[i + c];
+                }
+                inner->header.count = uint32_t(take - 1);
+                parents.push_back(&inner->header);
+                parentLowKeys.push_back(lowKeys[i]);
+                i += take;
+            }
+            level.swap(parents);
+            lowKeys.swap(parentLowKeys);
+            height_++;
+        }
+        root_ = level.front();
+    }
+
+    /*
+     * Visit every pair with lo <= key <= hi in key order, calling
+     * visitor(key, value). Return the number of visited pairs.
+     */
+    template <class Visitor>
+    std::size_t scan(const Key& lo, const Key& hi, Visitor visitor) const {
+        if (root_ == nullptr || hi < lo) {
+            return 0;
+        }
+        std::size_t visited = 0;
+        const LeafNode* leaf = findLeaf(lo);
+        std::size_t pos = bptree_detail::countLess(leaf->keys, leaf->header.count, lo);
+        while (leaf != nullptr) {
+            for (; pos < leaf->header.count; pos++) {
+                if (hi < leaf->keys[pos]) {
+                    return visited;
+                }
+                visitor(leaf->keys[pos], leaf->values[pos]);
+                visited++;
+            }
+            leaf = leaf->next;
+            pos = 0;
+        }
+        return visited;
+    }
+
+    Stats stats() const {
+        Stats result;
+        result.height = height_;
+        result.innerNodes = innerNodes_;
+        result.leafNodes = leafNodes_;
+        result.memoryBytes = (innerNodes_ + leafNodes_) * NodeBytes;
+        return result;
+    }
+
+private:
+    // Enough for any tree that fits in memory: INNER_CAPACITY >= 4.
+    static const std::size_t MAX_HEIGHT = 48;
+
+    static InnerNode* asInner(NodeHeader* node) {
+        return reinterpret_cast<InnerNode*>(node);
+    }
+
+    static const InnerNode* asInner(const NodeHeader* node) {
+        return reinterpret_cast<const InnerNode*>(node);
+    }
+
+    static LeafNode* asLeaf(NodeHeader* node) {
+        return reinterpret_cast<LeafNode*>(node);
+    }
+
+    static const LeafNode* asLeaf(const NodeHeader* node) {
+        return reinterpret_cast<const LeafNode*>(node);
+    }
+
+    const LeafNode* findLeaf(const Key& key) const {
+        const NodeHeader* node = root_;
+        while (!node->isLeaf) {
+            node = childFor(node, key);
+        }
+        return asLeaf(node);
+    }
+
+    LeafNode* newLeaf() {
+        LeafNode* leaf = static_cast<LeafNode*>(bptree_detail::alignedAllocate(NODE_ALIGNMENT, NodeBytes));
+        leaf->header.count = 0;
+        leaf->header.isLeaf = 1;
+        leaf->next = nullptr;
+        leafNodes_++;
+        return leaf;
+    }
+
+    InnerNode* newInner() {
+        InnerNode* inner = static_cast<InnerNode*>(bptree_detail::alignedAllocate(NODE_ALIGNMENT, NodeBytes));
+        inner->header.count = 0;
+        inner->header.isLeaf = 0;
+        innerNodes_++;
+        return inner;
+    }
+
+    void freeSubtree(NodeHeader* node) {
+        if (!node->isLeaf) {
+            InnerNode* inner = asInner(node);
+            for (std::size_t i = 0; i <= inner->header.count; i++) {
+                freeSubtree(inner->children[i]);
+            }
+        }
+        bptree_detail::alignedFree(node);
+    }
+
+    static void insertInLeaf(LeafNode* leaf, std::size_t pos, const Key& key, const Value& value) {
+        std::copy_backward(leaf->keys + pos, leaf->keys + leaf->header.count, leaf->keys + leaf->header.count + 1);
+        std::copy_backward(leaf->values + pos, leaf->values + leaf->header.count,
+                           leaf->values + leaf->header.count + 1);
+        leaf->keys[pos] = key;
+        leaf->values[pos] = value;
+        leaf->header.count++;
+    }
+
+    // Insert separator at keys[slot] and child at children[slot + 1].
+    static void insertInInner(InnerNode* inner, std::size_t slot, const Key& separator, NodeHeader* child) {
+        std::copy_backward(inner->keys + slot, inner->keys + inner->header.count,
+                           inner->keys + inner->header.count + 1);
+        std::copy_backward(inner->children + slot + 1, inner->children + inner->header.count + 1,
+                           inner->children + inner->header.count + 2);
+        inner->keys[slot] = separator;
+        inner->children[slot + 1] = child;
+        inner->header.count++;
+    }
+
+    /*
+     * Split a full inner node while inserting (separator, child) at slot. On
+     * return separator/child hold the key and the new right node to insert in
+     * the parent.
+     */
+    void splitInner(InnerNode* inner, std::size_t slot, Key& separator, NodeHeader*& child) {
+        Key keys[INNER_CAPACITY + 1];
+        NodeHeader* children[INNER_CAPACITY + 2];
+        std::copy(inner->keys, inner->keys + slot, keys);
+        keys[slot] = separator;
+        std::copy(inner->keys + slot, inner->keys + INNER_CAPACITY, keys + slot + 1);
+        std::copy(inner->children, inner->children + slot + 1, children);
+        children[slot + 1] = child;
+        std::copy(inner->children + slot + 1, inner->children + INNER_CAPACITY + 1, children + slot + 2);
+
+        const std::size_t total = INNER_CAPACITY + 1;
+        const std::size_t leftCount = total / 2;
+        InnerNode* right = newInner();
+
+        std::copy(keys, keys + leftCount, inner->keys);
+        std::copy(children, children + leftCount + 1, inner->children);
+        inner->header.count = uint32_t(leftCount);
+
+        const std::size_t rightCount = total - leftCount - 1;
+        std::copy(keys + leftCount + 1, keys + total, right->keys);
+        std::copy(children + leftCount + 1, children + total + 1, right->children);
+        right->header.count = uint32_t(rightCount);
+
+        separator = keys[leftCount];
+        child = &right->header;
+    }
+
+    NodeHeader* root_;
+    LeafNode* firstLeaf_;
+    std::size_t size_;
+    std::size_t height_;
+    std::size_t innerNodes_;
+    std::size_t leafNodes_;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef BLOCKED_BLOOM_FILTER_H
+#define BLOCKED_BLOOM_FILTER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Split-block Bloom filter (Putze et al., "Cache-, hash- and space-efficient
+ * Bloom filters"; the layout used by Impala and Parquet).
+ *
+ * The filter is an array of 256-bit blocks aligned on cache lines, so a key
+ * only ever touches one line. A key selects a block with the high half of
+ * its hash, and the low half multiplied by eight odd salts gives one bit in
+ * each of the eight 32-bit words of the block. With AVX2 both insert and
+ * probe are a handful of vector instructions; otherwise the eight words are
+ * handled in a loop.
+ *
+ * The number of blocks is derived from the expected key count and the
+ * requested bits per key. Inserting more keys than expected keeps the filter
+ * correct (no false negatives) but raises the false-positive rate.
+ */
+template <typename Key, class Hash = std::hash<Key>>
+class BlockedBloomFilter {
+public:
+    static const std::size_t BLOCK_BITS = 256;
+
+    BlockedBloomFilter(std::size_t expectedKeys, double bitsPerKey, const Hash& hash = Hash())
+        : hash_(hash), blocks_(nullptr), blockCount_(0), bitsPerKey_(bitsPerKey), inserted_(0) {
+        resize(expectedKeys);
+    }
+
+    BlockedBloomFilter(const BlockedBloomFilter&) = delete;
+    BlockedBloomFilter& operator=(const BlockedBloomFilter&) = delete;
+
+    ~BlockedBloomFilter() {
+        free(blocks_);
+    }
+
+    // Clear the filter and size it for expectedKeys keys
+    void resize(std::size_t expectedKeys) {
+        free(blocks_);
+        const double bits = std::ceil(double(expectedKeys) * bitsPerKey_);
+        blockCount_ = std::size_t(bits / BLOCK_BITS) + 1;
+        void* memory = nullptr;
+        if (posix_memalign(&memory, 64, blockCount_ * sizeof(Block)) != 0) {
+            throw std::bad_alloc();
+        }
+        blocks_ = static_cast<Block*>(memory);
+        for (std::size_t i = 0; i < blockCount_; i++) {
+            for (std::size_t w = 0; w < WORDS; w++) {
+                blocks_[i].words[w] = 0;
+            }
+        }
+        inserted_ = 0;
+    }
+
+    std::size_t memoryBytes() const {
+        return blockCount_ * sizeof(Block);
+    }
+
+    std::size_t inserted() const {
+        return inserted_;
+    }
+
+    /*
+     * Expected false-positive rate for the keys inserted so far, assuming
+     * uniform hashing. Block loads are Poisson distributed around the mean,
+     * and overloaded blocks dominate the rate, so the per-block rate is
+     * averaged over that distribution.
+     */
+    double expectedFalsePositiveRate() const {
+        const double keysPerBlock = double(inserted_) / double(blockCount_);
+        const std::size_t maxKeys = std::size_t(keysPerBlock * 4) + 64;
+        double probability = std::exp(-keysPerBlock);
+        double rate = 0;
+        for (std::size_t keys = 0; keys <= maxKeys; keys++) {
+            // A query bit in a word is set after the block received keys keys
+            const double bitSet = 1.0 - std::pow(1.0 - 1.0 / 32.0, double(keys));
+            rate += probability * std::pow(bitSet, double(WORDS));
+            probability *= keysPerBlock / double(keys + 1);
+        }
+        return rate;
+    }
+
+    void insert(const Key& key) {
+        const uint64_t hash = mix(uint64_t(hash_(key)));
+        Block& block = blocks_[blockIndex(hash)];
+#if defined(__AVX2__)
+        __m256i* words = reinterpret_cast<__m256i*>(block.words);
+        _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), blockMask(uint32_t(hash))));
+#else
+        for (std::size_t w = 0; w < WORDS; w++) {
+            block.words[w] |= bitFor(uint32_t(hash), w);
+        }
+#endif
+        inserted_++;
+    }
+
+    // False if key was never inserted, true if it probably was
+    bool mayContain(const Key& key) const {
+        const uint64_t hash = mix(uint64_t(hash_(key)));
+        const Block& block = blocks_[blockIndex(hash)];
+#if defined(__AVX2__)
+        const __m256i words = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+        return _mm256_testc_si256(words, blockMask(uint32_t(hash))) != 0;
+#else
+        for (std::size_t w = 0; w < WORDS; w++) {
+            if ((block.words[w] & bitFor(uint32_t(hash), w)) == 0) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+private:
+    static const std::size_t WORDS = BLOCK_BITS / 32;
+
+    struct alignas(32) Block {
+        uint32_t words[WORDS];
+    };
+
+    static const uint32_t* salts() {
+        static const uint32_t values[WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+        return values;
+    }
+
+    // Finalizer of MurmurHash3, std::hash is the identity for integers
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::size_t blockIndex(uint64_t hash) const {
+        return std::size_t(((hash >> 32) * uint64_t(blockCount_)) >> 32);
+    }
+
+    static uint32_t bitFor(uint32_t hash, std::size_t word) {
+        return uint32_t(1) << ((hash * salts()[word]) >> 27);
+    }
+
+#if defined(__AVX2__)
+    static __m256i blockMask(uint32_t hash) {
+        const __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts()));
+        const __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(hash)), salt), 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+    }
+#endif
+
+    Hash hash_;
+    Block* blocks_;
+    std::size_t blockCount_;
+    double bitsPerKey_;
+    std::size_t inserted_;
+};
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef COMPACT_CUCKOO_MAP_H
+#define COMPACT_CUCKOO_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Compact cuckoo hash map with quotienting, for 32-bit keys and small values.
+ *
+ * Keys are first scrambled by an invertible 32-bit mix (the MurmurHash3
+ * finalizer), so h = mix(key) identifies the key. With 2^q buckets the top q
+ * bits of h select the primary bucket and only the remaining 32 - q bits
+ * (the remainder) are stored; bucket index + remainder give back h, hence the
+ * key. The alternate bucket is primary XOR hash(remainder), as in partial-key
+ * cuckoo hashing, and one bit per slot records which of the two buckets the
+ * entry lives in.
+ *
+ * A slot is a bit-packed field of (remainder bits + 2) tag bits followed by
+ * the value bits; tag 0 marks an empty slot. Buckets have 4 slots, so the
+ * table runs at ~90-95% load before a cuckoo insertion fails and the number
+ * of buckets doubles. For int/int this is 34 + 32 - q bits per slot instead
+ * of the 64 bits of the raw pair.
+ */
+template <typename Key, typename Value>
+class CompactCuckooMap {
+    static_assert(std::is_integral<Key>::value && sizeof(Key) <= 4, "CompactCuckooMap needs keys of at most 32 bits.");
+    static_assert(std::is_trivially_copyable<Value>::value && sizeof(Value) <= 4,
+                  "CompactCuckooMap packs values of at most 32 bits.");
+
+public:
+    static const unsigned SLOTS_PER_BUCKET = 4;
+
+    CompactCuckooMap() : size_(0), kickState_(0x2545f4914f6cdd1dULL) {
+        allocate(MIN_BUCKET_BITS);
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    std::size_t bucketCount() const {
+        return std::size_t(1) << bucketBits_;
+    }
+
+    std::size_t slotBits() const {
+        return slotBits_;
+    }
+
+    std::size_t memoryBytes() const {
+        return words_.capacity() * sizeof(uint64_t);
+    }
+
+    double loadFactor() const {
+        return double(size_) / double(bucketCount() * SLOTS_PER_BUCKET);
+    }
+
+    // Grow so that n keys fit at the default load factor
+    void reserve(std::size_t n) {
+        unsigned bits = bucketBits_;
+        while (bits < MAX_BUCKET_BITS &&
+               double(n) > TARGET_LOAD_FACTOR * double((std::size_t(1) << bits) * SLOTS_PER_BUCKET)) {
+            bits++;
+        }
+        if (bits != bucketBits_) {
+            rebuild(bits);
+        }
+    }
+
+    bool find(const Key& key, Value& value) const {
+        const uint32_t hash = mix(uint32_t(key));
+        const uint64_t primary = hash >> remainderBits_;
+        const uint64_t remainder = hash & remainderMask();
+        const uint64_t alternate = alternateBucket(primary, remainder);
+        std::size_t slot = findSlot(primary, tagFor(remainder, false));
+        if (slot == NOT_FOUND) {
+            slot = findSlot(alternate, tagFor(remainder, true));
+            if (slot == NOT_FOUND) {
+                return false;
+            }
+        }
+        value = valueAt(slot);
+        return true;
+    }
+
+    // Insert key or overwrite its value.
+    void insert(const Key& key, const Value& value) {
+        const uint32_t hash = mix(uint32_t(key));
+        if (!updateExisting(hash, value)) {
+            insertNew(hash, toBits(value));
+            size_++;
+        }
+    }
+
+private:
+    static const unsigned MIN_BUCKET_BITS = 4;
+    static const unsigned MAX_BUCKET_BITS = 30;
+    static const unsigned VALUE_BITS = 8 * sizeof(Value);
+    static const unsigned MAX_KICKS = 500;
+    static constexpr double TARGET_LOAD_FACTOR = 0.9;
+    static const std::size_t NOT_FOUND = ~std::size_t(0);
+
+    // MurmurHash3 fmix32, a bijection on 32-bit integers
+    static uint32_t mix(uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x85ebca6bU;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    uint64_t remainderMask() const {
+        return (uint64_t(1) << remainderBits_) - 1;
+    }
+
+    uint64_t alternateBucket(uint64_t bucket, uint64_t remainder) const {
+        const uint64_t scrambled = (remainder + 1) * 0x9e3779b97f4a7c15ULL;
+        return bucket ^ (scrambled >> (64 - bucketBits_));
+    }
+
+    static uint64_t tagFor(uint64_t remainder, bool inAlternate) {
+        return ((remainder << 1) | (inAlternate ? 1 : 0)) + 1;
+    }
+
+    static uint64_t toBits(const Value& value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(Value));
+        return bits;
+    }
+
+    uint64_t readBits(std::size_t bitPos, unsigned width) const {
+        const std::size_t word = bitPos / 64;
+        const unsigned offset = unsigned(bitPos % 64);
+        uint64_t result = words_[word] >> offset;
+        if (offset + width > 64) {
+            result |= words_[word + 1] << (64 - offset);
+        }
+        return width == 64 ? result : result & ((uint64_t(1) << width) - 1);
+    }
+
+    void writeBits(std::size_t bitPos, unsigned width, uint64_t bits) {
+        const std::size_t word = bitPos / 64;
+        const unsigned offset = unsigned(bitPos % 64);
+        const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+        words_[word] = (words_[word] & ~(mask << offset)) | ((bits & mask) << offset);
+        if (offset + width > 64) {
+            const unsigned spill = 64 - offset;
+            words_[word + 1] = (words_[word + 1] & ~(mask >> spill)) | ((bits & mask) >> spill);
+        }
+    }
+
+    uint64_t tagAt(std::size_t slot) const {
+        return readBits(slot * slotBits_, tagBits_);
+    }
+
+    Value valueAt(std::size_t slot) const {
+        const uint32_t bits = uint32_t(readBits(slot * slotBits_ + tagBits_, VALUE_BITS));
+        Value value;
+        std::memcpy(&value, &bits, sizeof(Value));
+        return value;
+    }
+
+    void writeSlot(std::size_t slot, uint64_t tag, uint64_t valueBits) {
+        writeBits(slot * slotBits_, tagBits_, tag);
+        writeBits(slot * slotBits_ + tagBits_, VALUE_BITS, valueBits);
+    }
+
+    std::size_t findSlot(uint64_t bucket, uint64_t tag) const {
+        const std::size_t first = std::size_t(bucket) * SLOTS_PER_BUCKET;
+        for (std::size_t slot = first; slot < first + SLOTS_PER_BUCKET; slot++) {
+            if (tagAt(slot) == tag) {
+                return slot;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    bool updateExisting(uint32_t hash, const Value& value) {
+        const uint64_t primary = hash >> remainderBits_;
+        const uint64_t remainder = hash & remainderMask();
+        std::size_t slot = findSlot(primary, tagFor(remainder, false));
+        if (slot == NOT_FOUND) {
+            slot = findSlot(alternateBucket(primary, remainder), tagFor(remainder, true));
+        }
+        if (slot == NOT_FOUND) {
+            return false;
+        }
+        writeBits(slot * slotBits_ + tagBits_, VALUE_BITS, toBits(value));
+        return true;
+    }
+
+    // Insert a hash known to be absent, growing the table if cuckoo kicks fail.
+    void insertNew(uint32_t hash, uint64_t valueBits) {
+        while (!tryInsert(hash, valueBits)) {
+            rebuild(bucketBits_ + 1);
+        }
+    }
+
+    /*
+     * On failure the table is unchanged except that the element held in hand
+     * at the end of the kick chain is returned through hash/valueBits, so the
+     * caller can grow and retry with it.
+     */
+    bool tryInsert(uint32_t& hash, uint64_t& valueBits) {
+        uint64_t remainder = hash & remainderMask();
+        uint64_t bucket = hash >> remainderBits_;
+        bool inAlternate = false;
+        std::size_t empty = findSlot(bucket, 0);
+        if (empty == NOT_FOUND) {
+            bucket = alternateBucket(bucket, remainder);
+            inAlternate = true;
+            empty = findSlot(bucket, 0);
+        }
+        for (unsigned kick = 0; empty == NOT_FOUND && kick < MAX_KICKS; kick++) {
+            // Take the place of a random entry of the bucket and move that one to its other bucket
+            kickState_ ^= kickState_ << 13;
+            kickState_ ^= kickState_ >> 7;
+            kickState_ ^= kickState_ << 17;
+            const std::size_t victim = std::size_t(bucket) * SLOTS_PER_BUCKET + (kickState_ % SLOTS_PER_BUCKET);
+            const uint64_t victimTag = tagAt(victim) - 1;
+            const uint64_t victimValue = readBits(victim * slotBits_ + tagBits_, VALUE_BITS);
+            writeSlot(victim, tagFor(remainder, inAlternate), valueBits);
+
+            remainder = victimTag >> 1;
+            inAlternate = (victimTag & 1) == 0;
+            valueBits = victimValue;
+            bucket = alternateBucket(bucket, remainder);
+            empty = findSlot(bucket, 0);
+        }
+        if (empty != NOT_FOUND) {
+            writeSlot(empty, tagFor(remainder, inAlternate), valueBits);
+            return true;
+        }
+        // Give back the element in hand as a full hash
+        const uint64_t primary = inAlternate ? alternateBucket(bucket, remainder) : bucket;
+        hash = uint32_t((primary << remainderBits_) | remainder);
+        return false;
+    }
+
+    void allocate(unsigned bucketBits) {
+        bucketBits_ = bucketBits;
+        remainderBits_ = 32 - bucketBits;
+        tagBits_ = remainderBits_ + 2;
+        slotBits_ = tagBits_ + VALUE_BITS;
+        const std::size_t totalBits = bucketCount() * SLOTS_PER_BUCKET * slotBits_;
+        // One extra word so a field can always be read with two word accesses
+        words_.assign(totalBits / 64 + 2, 0);
+    }
+
+    void rebuild(unsigned bucketBits) {
+        std::vector<uint64_t> oldWords;
+        oldWords.swap(words_);
+        const unsigned oldBucketBits = bucketBits_;
+
+        // Decode every entry into (hash, value) using the old geometry
+        std::vector<std::pair<uint32_t, uint64_t>> entries;
+        entries.reserve(size_);
+        {
+            CompactCuckooMap view;
+            view.words_.swap(oldWords);
+            view.bucketBits_ = oldBucketBits;
+            view.remainderBits_ = 32 - oldBucketBits;
+            view.tagBits_ = view.remainderBits_ + 2;
+            view.slotBits_ = view.tagBits_ + VALUE_BITS;
+            const std::size_t slots = view.bucketCount() * SLOTS_PER_BUCKET;
+            for (std::size_t slot = 0; slot < slots; slot++) {
+                const uint64_t tag = view.tagAt(slot);
+                if (tag == 0) {
+                    continue;
+                }
+                const uint64_t remainder = (tag - 1) >> 1;
+                const uint64_t bucket = slot / SLOTS_PER_BUCKET;
+                const uint64_t primary = ((tag - 1) & 1) ? view.alternateBucket(bucket, remainder) : bucket;
+                entries.emplace_back(uint32_t((primary << view.remainderBits_) | remainder),
+                                     view.readBits(slot * view.slotBits_ + view.tagBits_, VALUE_BITS));
+            }
+        }
+
+        allocate(bucketBits);
+        for (auto& entry : entries) {
+            insertNew(entry.first, entry.second);
+        }
+    }
+
+    std::vector<uint64_t> words_;
+    unsigned bucketBits_;
+    unsigned remainderBits_;
+    unsigned tagBits_;
+    unsigned slotBits_;
+    std::size_t size_;
+    uint64_t kickState_;
+};
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef CONCURRENT_HOPSCOTCH_MAP_H
+#define CONCURRENT_HOPSCOTCH_MAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Concurrent hopscotch hash map with lock striping and optimistic reads.
+ *
+ * The bucket layout follows tsl::hopscotch_hash: every bucket keeps a
+ * neighborhood bitmap whose bit i says that bucket home + i holds an element
+ * hashing to home, and an element always lives within NEIGHBORHOOD_SIZE
+ * buckets of its home. Free buckets are brought closer to the home by moving
+ * elements backward inside their own neighborhoods.
+ *
+ * The bucket array is split in segments of SEGMENT_BUCKETS consecutive
+ * buckets, each with a mutex and a version counter used as a seqlock. A
+ * writer locks, in ascending order, every segment it may touch: from the
+ * first bucket whose neighborhood reaches its home to the last bucket the
+ * free-slot search may reach. Versions are odd while a writer holds the
+ * segment. Readers take no lock: they read the versions of the segments
+ * covering the neighborhood, probe it, and retry if a version changed; after
+ * MAX_OPTIMISTIC_READS failed attempts they lock the segments.
+ *
+ * Growing locks every segment, rehashes into a table twice as large and
+ * publishes it through an atomic pointer. Readers may still be probing the
+ * previous table, so replaced tables are only freed with the map.
+ *
+ * Keys and values are stored in std::atomic and must be trivially copyable.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class ConcurrentHopscotchMap {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "ConcurrentHopscotchMap stores keys and values in std::atomic.");
+
+public:
+    static const std::size_t NEIGHBORHOOD_SIZE = 32;
+    static const std::size_t SEGMENT_BUCKETS = 512;
+
+    explicit ConcurrentHopscotchMap(std::size_t initialCapacity = 1024, const Hash& hash = Hash())
+        : hash_(hash), size_(0) {
+        std::size_t capacity = 16;
+        while (capacity < initialCapacity) {
+            capacity *= 2;
+        }
+        Table* table = new Table(capacity);
+        tables_.emplace_back(table);
+        table_.store(table, std::memory_order_release);
+    }
+
+    ConcurrentHopscotchMap(const ConcurrentHopscotchMap&) = delete;
+    ConcurrentHopscotchMap& operator=(const ConcurrentHopscotchMap&) = delete;
+
+    std::size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t bucketCount() const {
+        return table_.load(std::memory_order_acquire)->capacity;
+    }
+
+    std::size_t segmentCount() const {
+        return table_.load(std::memory_order_acquire)->segmentCount;
+    }
+
+    std::size_t memoryBytes() const {
+        const Table* table = table_.load(std::memory_order_acquire);
+        return table->bucketCount * sizeof(Bucket) + table->segmentCount * sizeof(Segment);
+    }
+
+    // Number of lookups that gave up on optimistic reads and took the segment locks
+    std::size_t lockedReads() const {
+        return lockedReads_.load(std::memory_order_relaxed);
+    }
+
+    bool find(const Key& key, Value& value) const {
+        for (std::size_t attempt = 0; attempt < MAX_OPTIMISTIC_READS; attempt++) {
+            const Table* table = table_.load(std::memory_order_acquire);
+            const std::size_t home = table->home(hash_(key));
+            const std::size_t firstSegment = home / SEGMENT_BUCKETS;
+            const std::size_t lastSegment = (home + NEIGHBORHOOD_SIZE - 1) / SEGMENT_BUCKETS;
+            const uint64_t firstVersion = table->segments[firstSegment].version.load(std::memory_order_acquire);
+            const uint64_t lastVersion = table->segments[lastSegment].version.load(std::memory_order_acquire);
+            if ((firstVersion | lastVersion) & 1) {
+                continue;
+            }
+            Value found;
+            const bool hit = probe(*table, home, key, found);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (table->segments[firstSegment].version.load(std::memory_order_relaxed) == firstVersion &&
+                table->segments[lastSegment].version.load(std::memory_order_relaxed) == lastVersion) {
+                if (hit) {
+                    value = found;
+                }
+                return hit;
+            }
+        }
+
+        lockedReads_.fetch_add(1, std::memory_order_relaxed);
+        for (;;) {
+            const Table* table = table_.load(std::memory_order_acquire);
+            const std::size_t home = table->home(hash_(key));
+            const std::size_t firstSegment = home / SEGMENT_BUCKETS;
+            const std::size_t lastSegment = (home + NEIGHBORHOOD_SIZE - 1) / SEGMENT_BUCKETS;
+            for (std::size_t s = firstSegment; s <= lastSegment; s++) {
+                table->segments[s].lock.lock();
+            }
+            // A resize may have replaced the table while we waited
+            const bool current = table == table_.load(std::memory_order_acquire);
+            const bool hit = current && probe(*table, home, key, value);
+            for (std::size_t s = lastSegment + 1; s-- > firstSegment;) {
+                table->segments[s].lock.unlock();
+            }
+            if (current) {
+                return hit;
+            }
+        }
+    }
+
+    // Insert key or overwrite its value.
+    void insert(const Key& key, const Value& value) {
+        const std::size_t hash = hash_(key);
+        for (;;) {
+            Table* table = table_.load(std::memory_order_acquire);
+            const std::size_t home = table->home(hash);
+            const std::size_t firstSegment =
+                (home >= NEIGHBORHOOD_SIZE - 1 ? home - (NEIGHBORHOOD_SIZE - 1) : 0) / SEGMENT_BUCKETS;
+            const std::size_t lastSegment = (home + MAX_PROBES - 1) / SEGMENT_BUCKETS;
+            for (std::size_t s = firstSegment; s <= lastSegment; s++) {
+                table->segments[s].lock.lock();
+            }
+            InsertResult result = STALE_TABLE;
+            if (table == table_.load(std::memory_order_acquire)) {
+                for (std::size_t s = firstSegment; s <= lastSegment; s++) {
+                    table->segments[s].version.fetch_add(1, std::memory_order_relaxed);
+                }
+                // Bucket stores must not become visible before the odd versions
+                std::atomic_thread_fence(std::memory_order_release);
+                result = insertLocked(*table, home, key, value);
+                for (std::size_t s = firstSegment; s <= lastSegment; s++) {
+                    table->segments[s].version.fetch_add(1, std::memory_order_release);
+                }
+            }
+            for (std::size_t s = lastSegment + 1; s-- > firstSegment;) {
+                table->segments[s].lock.unlock();
+            }
+
+            if (result == INSERTED) {
+                size_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (result == UPDATED) {
+                return;
+            }
+            if (result == TABLE_FULL) {
+                grow(table);
+            }
+        }
+    }
+
+private:
+    static const std::size_t MAX_PROBES = 128;
+    static const std::size_t MAX_OPTIMISTIC_READS = 16;
+    static const uint64_t OCCUPIED = uint64_t(1) << 63;
+
+    enum InsertResult { INSERTED, UPDATED, TABLE_FULL, STALE_TABLE };
+
+    struct Bucket {
+        // Neighborhood bits, plus OCCUPIED when the bucket itself holds an element
+        std::atomic<uint64_t> info;
+        std::atomic<Key> key;
+        std::atomic<Value> value;
+    };
+
+    struct Segment {
+        std::mutex lock;
+        std::atomic<uint64_t> version;
+        // Keep two segments off the same cache line
+        char padding[64 - (sizeof(std::mutex) + sizeof(std::atomic<uint64_t>)) % 64];
+    };
+
+    struct Table {
+        // Home buckets are [0, capacity), the MAX_PROBES buckets after them only
+        // receive displaced elements, like the extra buckets at the end of tsl's array
+        std::size_t capacity;
+        unsigned shift;
+        std::size_t bucketCount;
+        std::size_t segmentCount;
+        std::unique_ptr<Bucket[]> buckets;
+        std::unique_ptr<Segment[]> segments;
+
+        explicit Table(std::size_t capacity_)
+            : capacity(capacity_), shift(64), bucketCount(capacity_ + MAX_PROBES),
+              segmentCount((bucketCount + SEGMENT_BUCKETS - 1) / SEGMENT_BUCKETS),
+              buckets(new Bucket[bucketCount]), segments(new Segment[segmentCount]) {
+            for (std::size_t c = capacity; c > 1; c >>= 1) {
+                shift--;
+            }
+            for (std::size_t i = 0; i < bucketCount; i++) {
+                buckets[i].info.store(0, std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < segmentCount; i++) {
+                segments[i].version.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // Fibonacci hashing so that identity hashes of consecutive keys spread
+        std::size_t home(std::size_t hash) const {
+            return shift >= 64 ? 0 : std::size_t((uint64_t(hash) * 0x9e3779b97f4a7c15ULL) >> shift);
+        }
+    };
+
+    static bool probe(const Table& table, std::size_t home, const Key& key, Value& value) {
+        uint64_t hops = table.buckets[home].info.load(std::memory_order_acquire) & ~OCCUPIED;
+        while (hops != 0) {
+            const std::size_t index = home + std::size_t(__builtin_ctzll(hops));
+            if (table.buckets[index].key.load(std::memory_order_relaxed) == key) {
+                value = table.buckets[index].value.load(std::memory_order_relaxed);
+                return true;
+            }
+            hops &= hops - 1;
+        }
+        return false;
+    }
+
+    static bool occupied(const Table& table, std::size_t index) {
+        return (table.buckets[index].info.load(std::memory_order_relaxed) & OCCUPIED) != 0;
+    }
+
+    static void setInfo(Table& table, std::size_t index, uint64_t set, uint64_t clear) {
+        const uint64_t info = table.buckets[index].info.load(std::memory_order_relaxed);
+        table.buckets[index].info.store((info | set) & ~clear, std::memory_order_release);
+    }
+
+    // Caller holds the segments of [home - NEIGHBORHOOD_SIZE + 1, home + MAX_PROBES).
+    static InsertResult insertLocked(Table& table, std::size_t home, const Key& key, const Value& value) {
+        uint64_t hops = table.buckets[home].info.load(std::memory_order_relaxed) & ~OCCUPIED;
+        while (hops != 0) {
+            const std::size_t index = home + std::size_t(__builtin_ctzll(hops));
+            if (table.buckets[index].key.load(std::memory_order_relaxed) == key) {
+                table.buckets[index].value.store(value, std::memory_order_relaxed);
+                return UPDATED;
+            }
+            hops &= hops - 1;
+        }
+
+        std::size_t empty = home;
+        while (empty < home + MAX_PROBES && occupied(table, empty)) {
+            empty++;
+        }
+        if (empty == home + MAX_PROBES) {
+            return TABLE_FULL;
+        }
+
+        // Hop the empty bucket back until it is in the neighborhood of home
+        while (empty - home >= NEIGHBORHOOD_SIZE) {
+            bool moved = false;
+            for (std::size_t from = empty - (NEIGHBORHOOD_SIZE - 1); from < empty && !moved; from++) {
+                const uint64_t fromHops = table.buckets[from].info.load(std::memory_order_relaxed) & ~OCCUPIED;
+                if (fromHops == 0 || from + std::size_t(__builtin_ctzll(fromHops)) >= empty) {
+                    continue;
+                }
+                const std::size_t offset = std::size_t(__builtin_ctzll(fromHops));
+                const std::size_t victim = from + offset;
+                table.buckets[empty].key.store(table.buckets[victim].key.load(std::memory_order_relaxed),
+                                              std::memory_order_relaxed);
+                table.buckets[empty].value.store(table.buckets[victim].value.load(std::memory_order_relaxed),
+                                                std::memory_order_relaxed);
+                setInfo(table, empty, OCCUPIED, 0);
+                setInfo(table, from, uint64_t(1) << (empty - from), uint64_t(1) << offset);
+                setInfo(table, victim, 0, OCCUPIED);
+                empty = victim;
+                moved = true;
+            }
+            if (!moved) {
+                return TABLE_FULL;
+            }
+        }
+
+        table.buckets[empty].key.store(key, std::memory_order_relaxed);
+        table.buckets[empty].value.store(value, std::memory_order_relaxed);
+        setInfo(table, empty, OCCUPIED, 0);
+        setInfo(table, home, uint64_t(1) << (empty - home), 0);
+        return INSERTED;
+    }
+
+    void grow(Table* table) {
+        for (std::size_t s = 0; s < table->segmentCount; s++) {
+            table->segments[s].lock.lock();
+        }
+        if (table == table_.load(std::memory_order_acquire)) {
+            std::size_t capacity = table->capacity * 2;
+            std::unique_ptr<Table> grown;
+            while (!grown) {
+                grown.reset(new Table(capacity));
+                for (std::size_t i = 0; i < table->bucketCount && grown; i++) {
+                    if (!occupied(*table, i)) {
+                        continue;
+                    }
+                    const Key key = table->buckets[i].key.load(std::memory_order_relaxed);
+                    const Value value = table->buckets[i].value.load(std::memory_order_relaxed);
+                    if (insertLocked(*grown, grown->home(hash_(key)), key, value) == TABLE_FULL) {
+                        grown.reset();
+                        capacity *= 2;
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> guard(tablesLock_);
+                tables_.emplace_back(grown.release());
+                table_.store(tables_.back().get(), std::memory_order_release);
+            }
+        }
+        for (std::size_t s = table->segmentCount; s-- > 0;) {
+            table->segments[s].lock.unlock();
+        }
+    }
+
+    Hash hash_;
+    std::atomic<Table*> table_;
+    std::atomic<std::size_t> size_;
+    mutable std::atomic<std::size_t> lockedReads_{0};
+    // Current and replaced tables, the last one is current
+    std::mutex tablesLock_;
+    std::vector<std::unique_ptr<Table>> tables_;
+};
+
+#endif
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <unordered_map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <list>
 #include <string>
 #include <queue>
@@ -9,6 +13,24 @@
 #include <algorithm> // for find
 #include <type_traits>
 #include "tsl/hopscotch_map.h"
+#include "BPlusTree.h"
+#include "LearnedIndex.h"
+#include "AdaptiveRadixTree.h"
+#include "PerfectHash.h"
+#include "DirectMap.h"
+#include "RowHashTable.h"
+#include "CompactCuckooMap.h"
+#include "ConcurrentHopscotchMap.h"
+#include "LockFreeHashTable.h"
+#include "RcuMap.h"
+#include "ShardedMap.h"
+#include "BlockedBloomFilter.h"
+#include "HugePageAllocator.h"
+#include "NodeAllocator.h"
+#include "HopscotchSnapshot.h"
+#include "IncrementalHopscotchMap.h"
+#include "InterleavedLookup.h"
+#include "HashFunctions.h"
 
 using namespace std;
 // Base Container interface
@@ -21,21 +43,216 @@ public:
     virtual chrono::nanoseconds probeKey(const Key& key, Value &value) const = 0;
     virtual ~ContainerInterface() {}
     virtual const std::string& getString() const = 0;
+
+    // Load a complete key set. Containers with a dedicated build path (sorting,
+    // bulk construction) override it; by default every pair goes through insert.
+    virtual chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) {
+        auto total = chrono::nanoseconds::zero();
+        for (size_t i = 0; i < keys.size(); i++) {
+            total += insert(keys[i], values[i]);
+        }
+        return total;
+    }
+
+    // Membership test without a value. The default goes through get() and pays
+    // for an exception on every miss; containers with a cheap find override it.
+    virtual bool contains(const Key& key) const {
+        try {
+            get(key);
+            return true;
+        } catch (const out_of_range&) {
+            return false;
+        }
+    }
+
+    // Look up n independent keys; found[i] tells whether values[i] was set.
+    // Containers that can overlap the lookups (prefetching, batched messages)
+    // override it, by default the keys are looked up one after the other.
+    virtual chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const {
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            try {
+                values[i] = get(keys[i]);
+                found[i] = true;
+            } catch (const out_of_range&) {
+                found[i] = false;
+            }
+        }
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    // Print statistics of the freshly loaded container, before any lookup
+    virtual void printLoadStats() const {}
+
+    // Print container specific statistics after the benchmark phases
+    virtual void printStats() const {}
 };
 
+// Name suffix and statistics of a container allocator, nothing for std::allocator
+template <class Allocator>
+struct AllocatorReport {
+    static string suffix() { return ""; }
+    static void printStats(const Allocator&) {}
+};
 
-// Container class for hopscotchmap
-template <typename Key, typename Value>
+template <class T>
+struct AllocatorReport<HugePageAllocator<T>> {
+    static string suffix() { return "(huge pages)"; }
+    static void printStats(const HugePageAllocator<T>&) {
+        const huge_page_detail::Usage& usage = huge_page_detail::usage();
+        cout << "Huge page allocator (process-wide): " << usage.hugetlbBytes.load() << " bytes mapped from hugetlbfs, "
+             << usage.madviseBytes.load() << " bytes mapped with MADV_HUGEPAGE (" << usage.hugetlbFailures.load()
+             << " MAP_HUGETLB failures), transparent huge pages in use: "
+             << huge_page_detail::transparentHugePageBytes() << " bytes" << endl;
+    }
+};
+
+template <class T>
+struct AllocatorReport<ArenaAllocator<T>> {
+    static string suffix() { return "(arena)"; }
+    static void printStats(const ArenaAllocator<T>& allocator) {
+        const node_allocator_detail::Arena& arena = allocator.arena();
+        cout << "Arena: " << arena.usedBytes() << " bytes used of " << arena.reservedBytes() << " reserved in "
+             << arena.chunks() << " chunks, " << arena.largeBytes << " bytes outside the arena" << endl;
+    }
+};
+
+template <class T>
+struct AllocatorReport<PoolAllocator<T>> {
+    static string suffix() { return "(pool)"; }
+    static void printStats(const PoolAllocator<T>& allocator) {
+        const node_allocator_detail::Pool& pool = allocator.pool();
+        cout << "Pool: " << pool.liveBytes() << " bytes live, " << pool.arena().reservedBytes() << " reserved in "
+             << pool.arena().chunks() << " chunks, " << pool.reused() << " blocks reused, " << pool.largeBytes
+             << " bytes outside the pool" << endl;
+    }
+};
+
+// Name suffix of a container hash function, nothing for std::hash
+template <class Hash>
+struct HashReport {
+    static string suffix() { return "(" + string(Hash::name()) + ")"; }
+};
+
+template <class Key>
+struct HashReport<std::hash<Key>> {
+    static string suffix() { return ""; }
+};
+
+// Name suffix of a hopscotch growth policy, nothing for power-of-two doubling
+template <class GrowthPolicy>
+struct GrowthReport {
+    static string suffix() { return ""; }
+};
+
+template <class GrowthFactor>
+struct GrowthReport<tsl::hh::fastrange_growth_policy<GrowthFactor>> {
+    static string suffix() {
+        return "(fastrange x" + to_string(GrowthFactor::num) + "/" + to_string(GrowthFactor::den) + ")";
+    }
+};
+
+template <class GrowthFactor>
+struct GrowthReport<tsl::hh::mod_growth_policy<GrowthFactor>> {
+    static string suffix() {
+        return "(modulo x" + to_string(GrowthFactor::num) + "/" + to_string(GrowthFactor::den) + ")";
+    }
+};
+
+// Name suffix and statistics of the hopscotch overflow storage, nothing for std::list
+template <class Overflow>
+struct OverflowReport {
+    static string suffix() { return ""; }
+    static void printStats(const Overflow&) {}
+};
+
+template <class ValueType, class Allocator, bool Indexed>
+struct OverflowReport<tsl::hh::hashed_overflow<ValueType, Allocator, Indexed>> {
+    static string suffix() { return Indexed ? "(indexed overflow)" : "(vector overflow)"; }
+    static void printStats(const tsl::hh::hashed_overflow<ValueType, Allocator, Indexed>& overflow) {
+        const tsl::hh::overflow_statistics stats = overflow.statistics();
+        cout << "Overflow lookups: " << stats.lookups << ", hits: " << stats.hits << ", hashes scanned: "
+             << stats.scanned << " (" << (stats.lookups ? double(stats.scanned) / stats.lookups : 0.0)
+             << "/lookup), keys compared: " << stats.compared << ", metadata: " << overflow.metadata_bytes()
+             << " bytes" << endl;
+    }
+};
+
+// Occupancy of a hopscotch table: where its elements sit relative to their
+// home bucket (in power-of-two distance bins), how full the neighborhoods are
+// and what the inserts cost in displacements and rehashes
+inline void printHopscotchStatistics(const tsl::hh::hopscotch_statistics& stats) {
+    cout << "Load factor: " << stats.load_factor << " (" << stats.size << " elements, " << stats.bucket_count
+         << " buckets), overflow: " << stats.overflow_size << ", neighborhood occupancy: "
+         << stats.average_neighborhood_occupancy << endl;
+    const size_t inBuckets = stats.size - stats.overflow_size;
+    cout << "Home-to-slot distance:";
+    for (size_t first = 0; first < stats.distance_histogram.size(); first = first ? first * 2 : 1) {
+        const size_t last = min(first ? first * 2 : 1, stats.distance_histogram.size());
+        size_t elements = 0;
+        for (size_t distance = first; distance < last; distance++)
+            elements += stats.distance_histogram[distance];
+        cout << " " << first;
+        if (last - first > 1)
+            cout << "-" << last - 1;
+        cout << ": " << (inBuckets ? 100.0 * elements / inBuckets : 0.0) << "%";
+    }
+    cout << endl;
+    cout << "Inserts: " << stats.bucket_inserts << " in buckets, " << stats.overflow_inserts
+         << " in overflow, displacements: " << stats.displacements << " ("
+         << (stats.bucket_inserts ? double(stats.displacements) / stats.bucket_inserts : 0.0)
+         << "/insert, max " << stats.max_displacements << "), rehashes: " << stats.load_rehashes
+         << " for load, " << stats.neighborhood_rehashes << " for full neighborhoods" << endl;
+}
+
+// probeBatch through lookup coroutines interleaved by InterleavedLookup.h, for
+// containers whose lookups chase pointers and cannot be prefetched in advance
+template <class Container, typename Key, typename Value>
+chrono::nanoseconds interleavedProbeBatch(const Container& container, const Key* keys, size_t n, Value* values, bool* found) {
+    auto start = chrono::high_resolution_clock::now();
+    interleaveLookups<const Value*>(
+        n, interleave_detail::DEFAULT_GROUP, [&](size_t i) { return interleavedFind(container, keys[i]); },
+        [&](size_t i, const Value* value) {
+            found[i] = value != nullptr;
+            if (value != nullptr)
+                values[i] = *value;
+        });
+    auto end = chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+}
+
+// Container class for hopscotchmap. StoreHash keeps a 32-bit hash per bucket
+// (tsl then limits the neighborhood to 30 buckets), compared before the keys.
+// Overflow holds the elements that find no room in their neighborhood, Hash
+// is std::hash or one of HashFunctions.h. GrowthPolicy maps hashes to buckets
+// (fastrange needs a hash with good high bits, not std::hash). CompactBuckets
+// packs the bitmap behind the pair with a 30-slot neighborhood, for keys and
+// values trivially copy constructible and destructible.
+template <typename Key, typename Value, class Allocator = std::allocator<std::pair<Key, Value>>, bool StoreHash = false,
+          class Overflow = std::list<std::pair<Key, Value>, Allocator>, class Hash = std::hash<Key>,
+          class GrowthPolicy = tsl::hh::power_of_two_growth_policy<2>, bool CompactBuckets = false>
 class HopscotchMapContainer : public ContainerInterface<Key, Value> {
-    tsl::hopscotch_map <Key, Value> container_;
+    static const unsigned int NeighborhoodSize = (StoreHash || CompactBuckets) ? 30 : 62;
+    tsl::hopscotch_map <Key, Value, Hash, std::equal_to<Key>, Allocator, NeighborhoodSize, StoreHash,
+                        GrowthPolicy, Overflow, CompactBuckets> container_;
+    // Slowest single insert, the one that paid for the last rehash
+    chrono::nanoseconds worstInsert_ = chrono::nanoseconds::zero();
     string containerName;
 public:
-    HopscotchMapContainer(){containerName = "HopscotchMap";}
+    HopscotchMapContainer(){
+        containerName = string("HopscotchMap") + (StoreHash ? "(stored hash)" : "") + AllocatorReport<Allocator>::suffix() +
+                        OverflowReport<Overflow>::suffix() + HashReport<Hash>::suffix() +
+                        GrowthReport<GrowthPolicy>::suffix() + (CompactBuckets ? "(compact buckets)" : "");
+        // Rehashes and bulk loads of large tables spread over the cores
+        container_.set_build_threads(max(1u, thread::hardware_concurrency()));
+    }
     chrono::nanoseconds insert(const Key& key, const Value& value) override {
         auto start = chrono::high_resolution_clock::now();
         container_[key] = value;
         auto end = chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        worstInsert_ = max(worstInsert_, duration);
         return duration;
     }
 
@@ -43,6 +260,10 @@ public:
         return container_.at(key);
     }
 
+    bool contains(const Key& key) const override {
+        return container_.count(key) != 0;
+    }
+
     chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
         auto start = chrono::high_resolution_clock::now();
         value = container_.at(key);
@@ -51,18 +272,56 @@ public:
         return duration;
     }
 
+    void printLoadStats() const override {
+        printHopscotchStatistics(container_.statistics());
+    }
+
+    // Prefetching find_batch, in chunks so the result pointers stay on the stack
+    chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const override {
+        const size_t CHUNK = 64;
+        const Value* results[CHUNK];
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t first = 0; first < n; first += CHUNK) {
+            const size_t count = min(CHUNK, n - first);
+            container_.find_batch(keys + first, count, results);
+            for (size_t i = 0; i < count; i++) {
+                found[first + i] = results[i] != nullptr;
+                if (results[i] != nullptr)
+                    values[first + i] = *results[i];
+            }
+        }
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
     const std::string& getString() const override {
         return containerName;
     }
+
+    void printStats() const override {
+        typedef typename std::conditional<
+            CompactBuckets,
+            tsl::detail_hopscotch_hash::hopscotch_compact_bucket<std::pair<Key, Value>, NeighborhoodSize, StoreHash>,
+            tsl::detail_hopscotch_hash::hopscotch_bucket<std::pair<Key, Value>, NeighborhoodSize, StoreHash>>::type Bucket;
+        const size_t memoryBytes = container_.bucket_count() * sizeof(Bucket);
+        cout << "Buckets: " << container_.bucket_count() << " x " << sizeof(Bucket) << " bytes, load factor: "
+             << container_.load_factor() << ", overflow: " << container_.overflow_size() << ", memory: "
+             << memoryBytes << " bytes ("
+             << (container_.size() ? double(memoryBytes) / container_.size() : 0.0) << " bytes/entry)" << endl;
+        cout << "Build threads: " << container_.build_threads() << endl;
+        cout << "Worst insert: " << worstInsert_.count() << " ns" << endl;
+        OverflowReport<Overflow>::printStats(container_.overflow_container());
+        AllocatorReport<Allocator>::printStats(container_.get_allocator());
+    }
 };
 
-// Container class for map
-template <typename Key, typename Value>
+// Container class for map, Allocator allocates the tree nodes
+template <typename Key, typename Value, class Allocator = std::allocator<std::pair<const Key, Value>>>
 class MapContainer : public ContainerInterface<Key, Value> {
-    map<Key, Value> container_;
+    map<Key, Value, std::less<Key>, Allocator> container_;
     string containerName;
 public:
-    MapContainer(){containerName = "Map";}
+    MapContainer(){containerName = "Map" + AllocatorReport<Allocator>::suffix();}
     chrono::nanoseconds insert(const Key& key, const Value& value) override {
         auto start = chrono::high_resolution_clock::now();
         container_[key] = value;
@@ -75,6 +334,10 @@ public:
         return container_.at(key);
     }
 
+    bool contains(const Key& key) const override {
+        return container_.count(key) != 0;
+    }
+
     chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
         auto start = chrono::high_resolution_clock::now();
         value = container_.at(key);
@@ -83,33 +346,419 @@ public:
         return duration;
     }
 
+    // Lookups interleaved as coroutines, one suspension per tree level
+    chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const override {
+        return interleavedProbeBatch(container_, keys, n, values, found);
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    // Visit all pairs with lo <= key <= hi in key order, return the number visited
+    template <class Visitor>
+    size_t rangeScan(const Key& lo, const Key& hi, Visitor visitor) const {
+        size_t visited = 0;
+        for (auto it = container_.lower_bound(lo); it != container_.end() && !(hi < it->first); ++it) {
+            visitor(it->first, it->second);
+            visited++;
+        }
+        return visited;
+    }
+
+    void printStats() const override {
+        AllocatorReport<Allocator>::printStats(container_.get_allocator());
+    }
+};
+
+// Container class for the cache-conscious B+tree, NodeBytes is the node size
+template <typename Key, typename Value, size_t NodeBytes = 256>
+class BPlusTreeContainer : public ContainerInterface<Key, Value> {
+    BPlusTree<Key, Value, NodeBytes> container_;
+    string containerName;
+public:
+    BPlusTreeContainer(){containerName = "BPlusTree(" + to_string(NodeBytes) + "B nodes)";}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in BPlusTreeContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    // Lookups interleaved as coroutines, one suspension per node
+    chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const override {
+        return interleavedProbeBatch(container_, keys, n, values, found);
+    }
+
     const std::string& getString() const override {
         return containerName;
     }
+
+    // Sort once and build the tree bottom-up instead of one insert per key
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        if (container_.size() != 0) {
+            return ContainerInterface<Key, Value>::bulkLoad(keys, values);
+        }
+        auto start = chrono::high_resolution_clock::now();
+        container_.bulkLoad(keys, values);
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    void printStats() const override {
+        auto stats = container_.stats();
+        cout << "B+tree height: " << stats.height << ", inner nodes: " << stats.innerNodes
+             << ", leaf nodes: " << stats.leafNodes << ", memory: " << stats.memoryBytes << " bytes ("
+             << (container_.size() ? double(stats.memoryBytes) / container_.size() : 0.0) << " bytes/entry)" << endl;
+    }
+
+    template <class Visitor>
+    size_t rangeScan(const Key& lo, const Key& hi, Visitor visitor) const {
+        return container_.scan(lo, hi, visitor);
+    }
 };
 
-// Container class for unordered_map
+// Container class for the adaptive radix tree, ordered like map
 template <typename Key, typename Value>
-class UnorderedMapContainer : public ContainerInterface<Key, Value> {
-    unordered_map<Key, Value> container_;
+class ArtContainer : public ContainerInterface<Key, Value> {
+    AdaptiveRadixTree<Key, Value> container_;
     string containerName;
 public:
-    UnorderedMapContainer(){containerName = "UnorderedMap";}
+    ArtContainer(){containerName = "AdaptiveRadixTree";}
     chrono::nanoseconds insert(const Key& key, const Value& value) override {
         auto start = chrono::high_resolution_clock::now();
-        container_[key] = value;
+        container_.insert(key, value);
         auto end = chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
         return duration;
     }
 
     const Value& get(const Key& key) const override {
-        return container_.at(key);
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in ArtContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
     }
 
     chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
         auto start = chrono::high_resolution_clock::now();
-        value = container_.at(key);
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        auto stats = container_.stats();
+        cout << "Nodes 4/16/48/256: " << stats.node4 << "/" << stats.node16 << "/" << stats.node48 << "/"
+             << stats.node256 << ", leaves: " << stats.leaves << ", memory: " << stats.memoryBytes << " bytes ("
+             << (stats.leaves ? double(stats.memoryBytes) / stats.leaves : 0.0) << " bytes/entry)" << endl;
+    }
+
+    // Visit all pairs with lo <= key <= hi in key order, return the number visited
+    template <class Visitor>
+    size_t rangeScan(const Key& lo, const Key& hi, Visitor visitor) const {
+        return container_.scan(lo, hi, visitor);
+    }
+};
+
+// Container class for the two-stage learned index (RMI) over sorted keys
+template <typename Key, typename Value>
+class LearnedIndexContainer : public ContainerInterface<Key, Value> {
+    RecursiveModelIndex<Key, Value> container_;
+    string containerName;
+public:
+    LearnedIndexContainer(){containerName = "LearnedIndex(RMI)";}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in LearnedIndexContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    // Train the models once over the whole key set
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        if (container_.size() != 0) {
+            return ContainerInterface<Key, Value>::bulkLoad(keys, values);
+        }
+        auto start = chrono::high_resolution_clock::now();
+        container_.build(keys, values);
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    void printStats() const override {
+        auto stats = container_.stats();
+        cout << "RMI leaf models: " << stats.leafModels << ", model size: " << stats.modelBytes << " bytes ("
+             << (container_.size() ? double(stats.modelBytes) / container_.size() : 0.0) << " bytes/key)"
+             << ", average error: " << stats.averageError << " positions, search window avg/max: "
+             << stats.averageSearchWindow << "/" << stats.maxSearchWindow << ", delta buffer: " << stats.deltaSize << endl;
+    }
+};
+
+// Container class for a minimal perfect hash over an immutable key set: values
+// live in a dense array indexed by the MPHF, FingerprintBits (0, 8 or 16) bits
+// per key reject most keys outside the set
+template <typename Key, typename Value, unsigned FingerprintBits = 16>
+class MinimalPerfectHashContainer : public ContainerInterface<Key, Value> {
+    static_assert(FingerprintBits == 0 || FingerprintBits == 8 || FingerprintBits == 16,
+                  "FingerprintBits must be 0, 8 or 16");
+    typedef typename conditional<FingerprintBits <= 8, uint8_t, uint16_t>::type Fingerprint;
+
+    BBHash<Key> perfectHash_;
+    vector<Value> values_;
+    vector<Fingerprint> fingerprints_;
+    // Keys inserted after the build, checked first
+    tsl::hopscotch_map<Key, Value> delta_;
+    string containerName;
+
+    static Fingerprint fingerprint(const Key& key) {
+        const uint64_t hash = mphf_detail::mix64(uint64_t(std::hash<Key>()(key)) ^ 0x5bd1e9955bd1e995ULL);
+        return Fingerprint(hash >> (64 - (FingerprintBits ? FingerprintBits : 8)));
+    }
+
+    // Delta first, then the slot of the perfect hash if its fingerprint matches
+    const Value* find(const Key& key) const {
+        if (!delta_.empty()) {
+            auto it = delta_.find(key);
+            if (it != delta_.end())
+                return &it->second;
+        }
+        const size_t index = perfectHash_.lookup(key);
+        if (index < values_.size() && (FingerprintBits == 0 || fingerprints_[index] == fingerprint(key)))
+            return &values_[index];
+        return nullptr;
+    }
+
+public:
+    MinimalPerfectHashContainer(){containerName = "MinimalPerfectHash(" + to_string(FingerprintBits) + "-bit fingerprints)";}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        delta_[key] = value;
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in MinimalPerfectHashContainer");
+        return *value;
+    }
+
+    // Without fingerprints a key absent from the build may be reported present
+    bool contains(const Key& key) const override {
+        return find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    // Build the MPHF over the distinct keys, then scatter values and fingerprints
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        if (!values_.empty() || !delta_.empty()) {
+            return ContainerInterface<Key, Value>::bulkLoad(keys, values);
+        }
+        auto start = chrono::high_resolution_clock::now();
+        vector<size_t> order(keys.size());
+        for (size_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+        vector<Key> distinctKeys;
+        vector<Value> distinctValues;
+        for (size_t i : order) {
+            if (!distinctKeys.empty() && distinctKeys.back() == keys[i]) {
+                distinctValues.back() = values[i];
+            } else {
+                distinctKeys.push_back(keys[i]);
+                distinctValues.push_back(values[i]);
+            }
+        }
+
+        perfectHash_.build(distinctKeys);
+        values_.resize(distinctKeys.size());
+        if (FingerprintBits != 0)
+            fingerprints_.resize(distinctKeys.size());
+        for (size_t i = 0; i < distinctKeys.size(); i++) {
+            const size_t index = perfectHash_.lookup(distinctKeys[i]);
+            values_[index] = distinctValues[i];
+            if (FingerprintBits != 0)
+                fingerprints_[index] = fingerprint(distinctKeys[i]);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    void printStats() const override {
+        const double keys = values_.empty() ? 1.0 : double(values_.size());
+        cout << "MPHF levels: " << perfectHash_.levels() << ", fallback keys: " << perfectHash_.fallbackSize()
+             << ", function: " << 8.0 * perfectHash_.memoryBytes() / keys << " bits/key"
+             << ", fingerprints: " << 8.0 * fingerprints_.size() * sizeof(Fingerprint) / keys << " bits/key"
+             << ", values: " << 8.0 * values_.size() * sizeof(Value) / keys << " bits/key"
+             << ", delta buffer: " << delta_.size() << endl;
+    }
+};
+
+// Container class for direct addressing over a bounded integer key range,
+// keys outside the range fall back to a hopscotch map
+template <typename Key, typename Value>
+class DirectMapContainer : public ContainerInterface<Key, Value> {
+    DirectMap<Key, Value> container_;
+    string containerName;
+public:
+    // Without a range, bulkLoad detects it from the loaded keys
+    DirectMapContainer(){containerName = "DirectMap";}
+    DirectMapContainer(const Key& lowKey, const Key& highKey) {
+        containerName = "DirectMap";
+        container_.setRange(lowKey, highKey);
+    }
+
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in DirectMapContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        auto start = chrono::high_resolution_clock::now();
+        if (!container_.hasRange())
+            container_.detectRange(keys);
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) +
+               ContainerInterface<Key, Value>::bulkLoad(keys, values);
+    }
+
+    void printStats() const override {
+        cout << "DirectMap range: ";
+        if (container_.hasRange())
+            cout << "[" << container_.lowKey() << ", +" << container_.span() << ")";
+        else
+            cout << "none";
+        cout << ", outliers: " << container_.outliers() << ", memory: " << container_.memoryBytes() << " bytes ("
+             << (container_.size() ? double(container_.memoryBytes()) / container_.size() : 0.0) << " bytes/entry)" << endl;
+    }
+};
+
+// Container class for the DRAM-row-bucketized table mirroring HashMem's layout:
+// one row per lookup, scanned linearly or with SIMD
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class RowHashContainer : public ContainerInterface<Key, Value> {
+    RowHashTable<Key, Value, Hash> container_;
+    string containerName;
+public:
+    RowHashContainer(size_t rowBytes = 2048, bool simdScan = true) : container_(rowBytes, simdScan) {
+        containerName = "RowHashTable(" + to_string(rowBytes) + "B rows, " + (simdScan ? "SIMD" : "linear") + " scan)" +
+                        HashReport<Hash>::suffix();
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in RowHashContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
         auto end = chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
         return duration;
@@ -118,6 +767,633 @@ public:
     const std::string& getString() const override {
         return containerName;
     }
+
+    void printStats() const override {
+        auto stats = container_.stats();
+        cout << "Rows: " << stats.rows << " x " << stats.rowBytes << " bytes (" << stats.rowCapacity
+             << " slots), fill avg/max: " << stats.averageFill << "/" << stats.maxFill << ", memory: "
+             << stats.memoryBytes << " bytes ("
+             << (container_.size() ? double(stats.memoryBytes) / container_.size() : 0.0) << " bytes/entry)" << endl;
+    }
+};
+
+// Container class for the compact cuckoo map: only key remainders and values
+// are stored, so get() returns a copy held in the container
+template <typename Key, typename Value>
+class CompactCuckooContainer : public ContainerInterface<Key, Value> {
+    CompactCuckooMap<Key, Value> container_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    CompactCuckooContainer(){containerName = "CompactCuckooMap";}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!container_.find(key, lastValue_))
+            throw out_of_range("Key not found in CompactCuckooContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        return container_.find(key, value);
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    // Size the table once for the whole key set instead of doubling during the load
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.reserve(container_.size() + keys.size());
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) +
+               ContainerInterface<Key, Value>::bulkLoad(keys, values);
+    }
+
+    void printStats() const override {
+        cout << "Buckets: " << container_.bucketCount() << " x " << CompactCuckooMap<Key, Value>::SLOTS_PER_BUCKET
+             << " slots of " << container_.slotBits() << " bits, load factor: " << container_.loadFactor()
+             << ", memory: " << container_.memoryBytes() << " bytes ("
+             << (container_.size() ? double(container_.memoryBytes()) / container_.size() : 0.0) << " bytes/entry, raw pair: "
+             << sizeof(Key) + sizeof(Value) << ")" << endl;
+    }
+};
+
+// Container class for the lock-striped concurrent hopscotch map. insert and
+// probeKey may be called from several threads, get() returns a per-container
+// copy and is single-threaded only
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class ConcurrentHopscotchContainer : public ContainerInterface<Key, Value> {
+    ConcurrentHopscotchMap<Key, Value, Hash> container_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    ConcurrentHopscotchContainer(){containerName = "ConcurrentHopscotchMap" + HashReport<Hash>::suffix();}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!container_.find(key, lastValue_))
+            throw out_of_range("Key not found in ConcurrentHopscotchContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        return container_.find(key, value);
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        const bool found = container_.find(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        if (!found)
+            throw out_of_range("Key not found in ConcurrentHopscotchContainer");
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        cout << "Buckets: " << container_.bucketCount() << ", segments: " << container_.segmentCount()
+             << ", memory: " << container_.memoryBytes() << " bytes ("
+             << (container_.size() ? double(container_.memoryBytes()) / container_.size() : 0.0)
+             << " bytes/entry), locked reads: " << container_.lockedReads() << endl;
+    }
+};
+
+// Container class for the lock-free CAS-based open-addressing table. insert and
+// probeKey may be called from several threads, get() returns a per-container
+// copy and is single-threaded only
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class LockFreeHashContainer : public ContainerInterface<Key, Value> {
+    LockFreeHashTable<Key, Value, Hash> container_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    LockFreeHashContainer(){containerName = "LockFreeHashTable" + HashReport<Hash>::suffix();}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!container_.find(key, lastValue_))
+            throw out_of_range("Key not found in LockFreeHashContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        return container_.find(key, value);
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        const bool found = container_.find(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        if (!found)
+            throw out_of_range("Key not found in LockFreeHashContainer");
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        cout << "Slots: " << container_.capacity() << ", load factor: "
+             << double(container_.size()) / container_.capacity() << ", migrations: " << container_.migrations()
+             << ", memory: " << container_.memoryBytes() << " bytes ("
+             << (container_.size() ? double(container_.memoryBytes()) / container_.size() : 0.0) << " bytes/entry)" << endl;
+    }
+};
+
+// Container class for the RCU read-mostly map: lookups never block, insert
+// publishes a new snapshot per call and bulkLoad one per batch. get() returns a
+// per-container copy and is single-threaded only
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class RcuMapContainer : public ContainerInterface<Key, Value> {
+    RcuMap<Key, Value, Hash> container_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    RcuMapContainer(){containerName = "RcuMap" + HashReport<Hash>::suffix();}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        container_.publish();
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!container_.find(key, lastValue_))
+            throw out_of_range("Key not found in RcuMapContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        return container_.find(key, value);
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        const bool found = container_.find(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        if (!found)
+            throw out_of_range("Key not found in RcuMapContainer");
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    // Queue the whole batch and publish a single snapshot
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < keys.size(); i++)
+            container_.insert(keys[i], values[i]);
+        container_.publish();
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    void printStats() const override {
+        cout << "Snapshot size: " << container_.size() << ", snapshots published: " << container_.publishes()
+             << ", awaiting reclamation: " << container_.retiredSnapshots() << endl;
+    }
+};
+
+// Container class for the shard-per-core map, used through a single client:
+// every operation is a round trip to the owning shard thread, bulkLoad sends
+// the whole key set before waiting. get() returns a per-container copy
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class ShardedMapContainer : public ContainerInterface<Key, Value> {
+    mutable ShardedMap<Key, Value, Hash> container_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    explicit ShardedMapContainer(size_t shards = max(1u, thread::hardware_concurrency()))
+        : container_(shards, 1) {
+        containerName = "ShardedMap(" + to_string(container_.shards()) + " shards)" + HashReport<Hash>::suffix();
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insertBatch(0, &key, &value, 1);
+        container_.flush(0);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        bool found = false;
+        container_.findBatch(0, &key, 1, &lastValue_, &found);
+        if (!found)
+            throw out_of_range("Key not found in ShardedMapContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        bool found = false;
+        container_.findBatch(0, &key, 1, &value, &found);
+        return found;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    // One round trip per batch instead of one per key
+    chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.findBatch(0, keys, n, values, found);
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insertBatch(0, keys.data(), values.data(), keys.size());
+        container_.flush(0);
+        auto end = chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    }
+
+    void printStats() const override {
+        size_t smallest = container_.shardSize(0), largest = smallest;
+        for (size_t s = 1; s < container_.shards(); s++) {
+            smallest = min(smallest, container_.shardSize(s));
+            largest = max(largest, container_.shardSize(s));
+        }
+        cout << "Shards: " << container_.shards() << ", keys per shard min/max: " << smallest << "/" << largest << endl;
+    }
+};
+
+// Container class for the hopscotch map with incremental resizing: the insert
+// crossing the load threshold no longer moves the whole table
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class IncrementalHopscotchContainer : public ContainerInterface<Key, Value> {
+    IncrementalHopscotchMap<Key, Value, Hash> container_;
+    chrono::nanoseconds worstInsert_ = chrono::nanoseconds::zero();
+    string containerName;
+public:
+    explicit IncrementalHopscotchContainer(size_t migrationStep = 8) : container_(migrationStep) {
+        containerName = "IncrementalHopscotchMap(" + to_string(container_.migrationStep()) + " per insert)" +
+                        HashReport<Hash>::suffix();
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        worstInsert_ = max(worstInsert_, duration);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        const Value* value = container_.find(key);
+        if (value == nullptr)
+            throw out_of_range("Key not found in IncrementalHopscotchContainer");
+        return *value;
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.find(key) != nullptr;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        cout << "Buckets: " << container_.bucketCount() << ", resizes: " << container_.resizes()
+             << ", still migrating: " << container_.pendingMigration() << " entries" << endl;
+        cout << "Worst insert: " << worstInsert_.count() << " ns" << endl;
+    }
+};
+
+// Container class for a hopscotch table served from an mmap-ed snapshot file:
+// bulkLoad builds the table, writes the snapshot to path, drops the table and
+// maps the file. Later inserts go to an in-memory delta, like the perfect hash.
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class HopscotchSnapshotContainer : public ContainerInterface<Key, Value> {
+    string path_;
+    unique_ptr<HopscotchSnapshot<Key, Value, Hash>> snapshot_;
+    tsl::hopscotch_map<Key, Value, Hash> delta_;
+    chrono::nanoseconds buildTime_;
+    chrono::nanoseconds writeTime_;
+    chrono::nanoseconds openTime_;
+    mutable Value lastValue_;
+    string containerName;
+public:
+    explicit HopscotchSnapshotContainer(const string& path)
+        : path_(path), buildTime_(0), writeTime_(0), openTime_(0) {
+        containerName = "HopscotchSnapshot(mmap)" + HashReport<Hash>::suffix();
+    }
+    ~HopscotchSnapshotContainer() {
+        if (snapshot_) {
+            snapshot_.reset();
+            remove(path_.c_str());
+        }
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        delta_[key] = value;
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    // Build, persist and reopen; the returned time covers all three steps
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        if (snapshot_ || !delta_.empty()) {
+            return ContainerInterface<Key, Value>::bulkLoad(keys, values);
+        }
+        auto start = chrono::high_resolution_clock::now();
+        {
+            tsl::hopscotch_map<Key, Value, Hash> table;
+            table.reserve(keys.size());
+            for (size_t i = 0; i < keys.size(); i++)
+                table[keys[i]] = values[i];
+            auto built = chrono::high_resolution_clock::now();
+            buildTime_ = chrono::duration_cast<chrono::nanoseconds>(built - start);
+            HopscotchSnapshot<Key, Value, Hash>::write(table, path_);
+            writeTime_ = chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - built);
+        }
+        auto opening = chrono::high_resolution_clock::now();
+        snapshot_.reset(new HopscotchSnapshot<Key, Value, Hash>(path_));
+        auto end = chrono::high_resolution_clock::now();
+        openTime_ = chrono::duration_cast<chrono::nanoseconds>(end - opening);
+        return chrono::duration_cast<chrono::nanoseconds>(end - start);
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!delta_.empty()) {
+            auto it = delta_.find(key);
+            if (it != delta_.end())
+                return it->second;
+        }
+        if (!snapshot_ || !snapshot_->find(key, lastValue_))
+            throw out_of_range("Key not found in HopscotchSnapshotContainer");
+        return lastValue_;
+    }
+
+    bool contains(const Key& key) const override {
+        Value value;
+        return delta_.count(key) != 0 || (snapshot_ && snapshot_->find(key, value));
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        if (!snapshot_)
+            return;
+        cout << "Snapshot " << path_ << ": " << snapshot_->fileBytes() << " bytes ("
+             << (snapshot_->size() ? double(snapshot_->fileBytes()) / snapshot_->size() : 0.0) << " bytes/entry), "
+             << snapshot_->bucketCount() << " buckets, overflow: " << snapshot_->overflowSize() << endl;
+        cout << "Snapshot build: " << buildTime_.count() << " ns, write: " << writeTime_.count()
+             << " ns, reopen via mmap: " << openTime_.count() << " ns" << endl;
+    }
+};
+
+// Container class for unordered_map. With HugePageAllocator only the bucket
+// array is large enough for huge pages, the nodes stay on the heap; with
+// ArenaAllocator or PoolAllocator it is the other way round.
+template <typename Key, typename Value, class Allocator = std::allocator<std::pair<const Key, Value>>,
+          class Hash = std::hash<Key>>
+class UnorderedMapContainer : public ContainerInterface<Key, Value> {
+    unordered_map<Key, Value, Hash, std::equal_to<Key>, Allocator> container_;
+    string containerName;
+public:
+    UnorderedMapContainer(){
+        containerName = "UnorderedMap" + AllocatorReport<Allocator>::suffix() + HashReport<Hash>::suffix();
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        container_[key] = value;
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        return container_.at(key);
+    }
+
+    bool contains(const Key& key) const override {
+        return container_.count(key) != 0;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = container_.at(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    // Lookups interleaved as coroutines, one suspension per chain node
+    chrono::nanoseconds probeBatch(const Key* keys, size_t n, Value* values, bool* found) const override {
+        return interleavedProbeBatch(container_, keys, n, values, found);
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        AllocatorReport<Allocator>::printStats(container_.get_allocator());
+    }
+};
+
+// Container class making a single-threaded container shareable: lookups take a
+// std::shared_mutex in shared mode, inserts in exclusive mode
+template <typename Key, typename Value, class Inner = UnorderedMapContainer<Key, Value>>
+class SharedMutexContainer : public ContainerInterface<Key, Value> {
+    Inner container_;
+    mutable shared_mutex lock_;
+    string containerName;
+public:
+    SharedMutexContainer(){containerName = "SharedMutex<" + container_.getString() + ">";}
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        {
+            unique_lock<shared_mutex> guard(lock_);
+            container_.insert(key, value);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const Value& get(const Key& key) const override {
+        shared_lock<shared_mutex> guard(lock_);
+        return container_.get(key);
+    }
+
+    bool contains(const Key& key) const override {
+        shared_lock<shared_mutex> guard(lock_);
+        return container_.contains(key);
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        {
+            shared_lock<shared_mutex> guard(lock_);
+            value = container_.get(key);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        shared_lock<shared_mutex> guard(lock_);
+        container_.printStats();
+    }
+};
+
+// Container class putting a blocked Bloom filter in front of another container:
+// keys the filter rejects are answered without touching the inner table. The
+// filter starts sized for expectedKeys keys inserted one by one, bulkLoad into
+// an empty container resizes it for the loaded key set.
+template <typename Key, typename Value, class Inner = HopscotchMapContainer<Key, Value>, class Hash = std::hash<Key>>
+class BloomFilterContainer : public ContainerInterface<Key, Value> {
+    Inner container_;
+    BlockedBloomFilter<Key, Hash> filter_;
+    double bitsPerKey_;
+    // Lookups of absent keys: rejected by the filter or passed as false positives
+    mutable size_t rejected_;
+    mutable size_t falsePositives_;
+    string containerName;
+public:
+    static constexpr size_t DEFAULT_EXPECTED_KEYS = size_t(1) << 20;
+
+    explicit BloomFilterContainer(double bitsPerKey = 10, size_t expectedKeys = DEFAULT_EXPECTED_KEYS)
+        : filter_(expectedKeys, bitsPerKey), bitsPerKey_(bitsPerKey), rejected_(0), falsePositives_(0) {
+        containerName = "BloomFilter" + to_string(int(bitsPerKey)) + "<" + container_.getString() + ">";
+    }
+    chrono::nanoseconds insert(const Key& key, const Value& value) override {
+        auto start = chrono::high_resolution_clock::now();
+        filter_.insert(key);
+        container_.insert(key, value);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    chrono::nanoseconds bulkLoad(const vector<Key>& keys, const vector<Value>& values) override {
+        if (filter_.inserted() == 0)
+            filter_.resize(keys.size());
+        return ContainerInterface<Key, Value>::bulkLoad(keys, values);
+    }
+
+    const Value& get(const Key& key) const override {
+        if (!filter_.mayContain(key)) {
+            rejected_++;
+            throw out_of_range("Key not found in BloomFilterContainer");
+        }
+        return container_.get(key);
+    }
+
+    bool contains(const Key& key) const override {
+        if (!filter_.mayContain(key)) {
+            rejected_++;
+            return false;
+        }
+        if (container_.contains(key))
+            return true;
+        falsePositives_++;
+        return false;
+    }
+
+    chrono::nanoseconds probeKey(const Key& key, Value& value) const override {
+        auto start = chrono::high_resolution_clock::now();
+        value = get(key);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        return duration;
+    }
+
+    const std::string& getString() const override {
+        return containerName;
+    }
+
+    void printStats() const override {
+        const size_t absent = rejected_ + falsePositives_;
+        cout << "Bloom filter: " << filter_.memoryBytes() << " bytes for " << filter_.inserted() << " keys ("
+             << (filter_.inserted() ? double(filter_.memoryBytes()) * 8 / filter_.inserted() : 0.0)
+             << " bits/key, target " << bitsPerKey_ << "), expected false-positive rate "
+             << filter_.expectedFalsePositiveRate() * 100 << "%" << endl;
+        cout << "Bloom filter absent-key lookups: " << absent << ", rejected " << rejected_ << ", false positives "
+             << falsePositives_ << " (" << (absent ? double(falsePositives_) * 100 / absent : 0.0) << "%)" << endl;
+        container_.printStats();
+    }
 };
 
 // Container class for multimap
@@ -0,0 +1,131 @@
+#ifndef DIRECT_MAP_H
+#define DIRECT_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "tsl/hopscotch_map.h"
+
+/*
+ * Direct-addressed map for dense, bounded integer key domains.
+ *
+ * Keys in [lowKey, lowKey + span) are stored at values[key - lowKey] with a
+ * presence bitmap; a lookup is one bit test plus one array access. Keys
+ * outside the range go to a hopscotch map, so the structure stays correct
+ * for any key set and only degrades to a hash map for the outliers.
+ *
+ * The range is either given explicitly (setRange) or detected from a key set
+ * (detectRange), which only enables direct addressing if the keys cover at
+ * least minDensity of [min key, max key].
+ */
+template <typename Key, typename Value>
+class DirectMap {
+    static_assert(std::is_integral<Key>::value, "DirectMap needs integer keys.");
+    typedef typename std::make_unsigned<Key>::type UnsignedKey;
+
+public:
+    DirectMap() : lowKey_(0), size_(0) {}
+
+    std::size_t size() const {
+        return size_ + outliers_.size();
+    }
+
+    bool hasRange() const {
+        return !values_.empty();
+    }
+
+    Key lowKey() const {
+        return lowKey_;
+    }
+
+    std::size_t span() const {
+        return values_.size();
+    }
+
+    std::size_t outliers() const {
+        return outliers_.size();
+    }
+
+    std::size_t memoryBytes() const {
+        return values_.capacity() * sizeof(Value) + presence_.capacity() * sizeof(uint64_t) +
+               outliers_.bucket_count() * (sizeof(Key) + sizeof(Value) + sizeof(uint64_t));
+    }
+
+    // Directly address [lowKey, highKey]; existing outliers in range move to the array.
+    void setRange(Key lowKey, Key highKey) {
+        std::vector<std::pair<Key, Value>> moved;
+        for (std::size_t i = 0; i < values_.size(); i++) {
+            if (present(i)) {
+                moved.emplace_back(Key(UnsignedKey(lowKey_) + UnsignedKey(i)), values_[i]);
+            }
+        }
+        for (auto it = outliers_.begin(); it != outliers_.end(); ++it) {
+            moved.emplace_back(it->first, it->second);
+        }
+
+        lowKey_ = lowKey;
+        const std::size_t span = std::size_t(UnsignedKey(highKey) - UnsignedKey(lowKey)) + 1;
+        values_.assign(span, Value());
+        presence_.assign((span + 63) / 64, 0);
+        outliers_.clear();
+        size_ = 0;
+        for (const auto& pair : moved) {
+            insert(pair.first, pair.second);
+        }
+    }
+
+    // Enable direct addressing if keys are dense enough over their [min, max] range.
+    bool detectRange(const std::vector<Key>& keys, double minDensity = 0.5) {
+        if (keys.empty()) {
+            return false;
+        }
+        auto bounds = std::minmax_element(keys.begin(), keys.end());
+        const double span = double(UnsignedKey(*bounds.second) - UnsignedKey(*bounds.first)) + 1.0;
+        if (double(keys.size()) / span < minDensity) {
+            return false;
+        }
+        setRange(*bounds.first, *bounds.second);
+        return true;
+    }
+
+    const Value* find(const Key& key) const {
+        const std::size_t index = std::size_t(UnsignedKey(key) - UnsignedKey(lowKey_));
+        if (index < values_.size()) {
+            return present(index) ? &values_[index] : nullptr;
+        }
+        if (outliers_.empty()) {
+            return nullptr;
+        }
+        auto it = outliers_.find(key);
+        return it == outliers_.end() ? nullptr : &it->second;
+    }
+
+    void insert(const Key& key, const Value& value) {
+        const std::size_t index = std::size_t(UnsignedKey(key) - UnsignedKey(lowKey_));
+        if (index < values_.size()) {
+            if (!present(index)) {
+                presence_[index / 64] |= uint64_t(1) << (index % 64);
+                size_++;
+            }
+            values_[index] = value;
+        } else {
+            outliers_[key] = value;
+        }
+    }
+
+private:
+    bool present(std::size_t index) const {
+        return (presence_[index / 64] >> (index % 64)) & 1;
+    }
+
+    Key lowKey_;
+    std::size_t size_;
+    std::vector<Value> values_;
+    std::vector<uint64_t> presence_;
+    tsl::hopscotch_map<Key, Value> outliers_;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef HASH_FUNCTIONS_H
+#define HASH_FUNCTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+/*
+ * Hash functors to plug into the hash containers in place of std::hash.
+ *
+ * libstdc++ hashes integers to themselves. With power-of-two tables the home
+ * bucket is then the low bits of the key, so keys sharing their low bits
+ * (strided identifiers, aligned addresses) all land in the same bucket: the
+ * hopscotch neighborhood fills up and every further key overflows. Each
+ * functor below makes both the low bits of the hash (power-of-two and modulo
+ * tables) and its high bits (fastrange_growth_policy) depend on every key bit:
+ *  - MultiplyShiftHash: one multiplication by an odd constant (Dietzfelbinger
+ *    et al.). Only the top bits of the product depend on every key bit, so
+ *    the top half is xored onto the bottom half and kept in place. The
+ *    cheapest, and the weakest mixing of the four.
+ *  - Fmix64Hash: the MurmurHash3 finalizer, two multiplications and three
+ *    xor-shifts, every input bit flips each output bit with probability 1/2.
+ *  - WyHash: the wyhash mixing step, a 64x64->128 multiplication of the key
+ *    xored with two secrets, folded to 64 bits.
+ *  - Crc32cHash: two CRC32C instructions (SSE4.2, a table-driven CRC32C
+ *    without it), one over the key for the low half and one over the key
+ *    multiplied by an odd constant for the high half. CRC is affine in its
+ *    seed, so two seeds over the same word would only differ by a constant.
+ *
+ * Keys that are not integers are first reduced to a word with std::hash.
+ */
+namespace hash_detail {
+
+template <typename Key>
+inline uint64_t toWord(const Key& key) {
+    if constexpr (std::is_integral<Key>::value || std::is_enum<Key>::value) {
+        return uint64_t(key);
+    } else {
+        return uint64_t(std::hash<Key>()(key));
+    }
+}
+
+inline uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Both halves of the 128-bit product xored together
+inline uint64_t mulFold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = (unsigned __int128)a * b;
+    return uint64_t(product) ^ uint64_t(product >> 64);
+#else
+    const uint64_t aLow = a & 0xffffffffULL, aHigh = a >> 32;
+    const uint64_t bLow = b & 0xffffffffULL, bHigh = b >> 32;
+    const uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh;
+    const uint64_t highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+    const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffffULL) + (highLow & 0xffffffffULL);
+    const uint64_t low = (middle << 32) | (lowLow & 0xffffffffULL);
+    const uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+    return low ^ high;
+#endif
+}
+
+#if !defined(__SSE4_2__)
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78) one byte at a time
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    Crc32cTable() {
+        for (uint32_t byte = 0; byte < 256; byte++) {
+            uint32_t crc = byte;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+            }
+            entries[byte] = crc;
+        }
+    }
+};
+
+inline const Crc32cTable& crc32cTable() {
+    static const Crc32cTable table;
+    return table;
+}
+#endif
+
+// Same result as the SSE4.2 crc32 instruction on a 64-bit operand
+inline uint32_t crc32c(uint32_t crc, uint64_t word) {
+#if defined(__SSE4_2__)
+    return uint32_t(_mm_crc32_u64(crc, word));
+#else
+    const Crc32cTable& table = crc32cTable();
+    for (int byte = 0; byte < 8; byte++) {
+        crc = table.entries[(crc ^ uint32_t(word >> (8 * byte))) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+#endif
+}
+
+} // namespace hash_detail
+
+template <typename Key>
+struct MultiplyShiftHash {
+    static const char* name() { return "multiply-shift"; }
+
+    size_t operator()(const Key& key) const {
+        const uint64_t product = hash_detail::toWord(key) * 0x9E3779B97F4A7C15ULL;
+        return size_t(product ^ (product >> 32));
+    }
+};
+
+template <typename Key>
+struct Fmix64Hash {
+    static const char* name() { return "fmix64"; }
+
+    size_t operator()(const Key& key) const {
+        return size_t(hash_detail::fmix64(hash_detail::toWord(key)));
+    }
+};
+
+template <typename Key>
+struct WyHash {
+    static const char* name() { return "wyhash"; }
+
+    size_t operator()(const Key& key) const {
+        const uint64_t word = hash_detail::toWord(key);
+        return size_t(hash_detail::mulFold(word ^ 0xa0761d6478bd642fULL, word ^ 0xe7037ed1a0b428dbULL));
+    }
+};
+
+template <typename Key>
+struct Crc32cHash {
+    static const char* name() {
+#if defined(__SSE4_2__)
+        return "crc32c";
+#else
+        return "crc32c(table)";
+#endif
+    }
+
+    size_t operator()(const Key& key) const {
+        const uint64_t word = hash_detail::toWord(key);
+        const uint32_t high = hash_detail::crc32c(0u, word * 0x9E3779B97F4A7C15ULL);
+        return size_t((uint64_t(high) << 32) | hash_detail::crc32c(0u, word));
+    }
+};
+
+#endif
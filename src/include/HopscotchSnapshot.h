@@ -0,0 +1,288 @@
+#ifndef HOPSCOTCH_SNAPSHOT_H
+#define HOPSCOTCH_SNAPSHOT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tsl/hopscotch_map.h"
+
+namespace snapshot_detail {
+
+static const char MAGIC[8] = {'H', 'O', 'P', 'S', 'N', 'A', 'P', '1'};
+static const uint32_t VERSION = 1;
+
+// Fixed-size file header, every position in the file is an offset from its start
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t keyBytes;
+    uint32_t valueBytes;
+    uint32_t neighborhoodSize;
+    // Power-of-two bucket count of the table, the array has neighborhoodSize - 1 more
+    uint64_t bucketCount;
+    uint64_t bucketSlots;
+    uint64_t size;
+    uint64_t overflowCount;
+    uint64_t bucketsOffset;
+    uint64_t overflowOffset;
+    uint64_t fileBytes;
+};
+
+/*
+ * One bucket of the array. info holds the tsl layout: bit 0 occupied, bit 1
+ * overflow, the neighborhood bitmap from bit 2 on.
+ */
+template <typename Key, typename Value>
+struct Bucket {
+    uint64_t info;
+    Key key;
+    Value value;
+};
+
+template <typename Key, typename Value>
+struct OverflowEntry {
+    Key key;
+    Value value;
+};
+
+inline uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace snapshot_detail
+
+/*
+ * Read-only image of a tsl::hopscotch_map that is queried in place through
+ * mmap.
+ *
+ * write() stores the bucket array exactly as the table lays it out (element,
+ * occupied and overflow flags, neighborhood bitmap) followed by the overflow
+ * elements sorted by key. The file has no pointers, only offsets from its
+ * start, so it can be mapped at any address. Opening a snapshot maps the
+ * file and checks the header; nothing is deserialized or rebuilt, pages come
+ * from the page cache on first touch (or up front with prefault).
+ *
+ * A lookup replays the hopscotch search: the home bucket is hash & (buckets -
+ * 1), its bitmap lists the buckets of the neighborhood holding keys that hash
+ * there, and the overflow flag sends the search to the sorted overflow array.
+ * This requires the power-of-two growth policy and a hash function that gives
+ * the same result in every process (std::hash for integers does), and keys
+ * and values must be trivially copyable. Files are native endian.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>, unsigned int NeighborhoodSize = 62>
+class HopscotchSnapshot {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "HopscotchSnapshot stores keys and values as raw bytes.");
+
+public:
+    typedef snapshot_detail::Bucket<Key, Value> Bucket;
+    typedef snapshot_detail::OverflowEntry<Key, Value> OverflowEntry;
+
+    /*
+     * Serialize map to path. The file is written next to path and renamed
+     * over it, so readers never see a partially written snapshot.
+     */
+    template <class KeyEqual, class Allocator, bool StoreHash, std::size_t GrowthFactor, class OverflowContainer,
+              bool CompactBuckets>
+    static void write(const tsl::hopscotch_map<Key, Value, Hash, KeyEqual, Allocator, NeighborhoodSize, StoreHash,
+                                               tsl::hh::power_of_two_growth_policy<GrowthFactor>, OverflowContainer,
+                                               CompactBuckets>& map,
+                      const std::string& path) {
+        snapshot_detail::Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, snapshot_detail::MAGIC, sizeof(header.magic));
+        header.version = snapshot_detail::VERSION;
+        header.keyBytes = sizeof(Key);
+        header.valueBytes = sizeof(Value);
+        header.neighborhoodSize = NeighborhoodSize;
+        header.bucketCount = map.bucket_count();
+        header.size = map.size();
+
+        std::vector<Bucket> buckets;
+        map.visit_buckets([&](uint64_t neighborhood, bool hasOverflow, const std::pair<Key, Value>* element) {
+            Bucket bucket;
+            std::memset(&bucket, 0, sizeof(bucket));
+            bucket.info = (neighborhood << 2) | (hasOverflow ? 2 : 0) | (element != nullptr ? 1 : 0);
+            if (element != nullptr) {
+                bucket.key = element->first;
+                bucket.value = element->second;
+            }
+            buckets.push_back(bucket);
+        });
+        std::vector<OverflowEntry> overflow;
+        map.visit_overflow([&](const std::pair<Key, Value>& element) {
+            OverflowEntry entry;
+            std::memset(&entry, 0, sizeof(entry));
+            entry.key = element.first;
+            entry.value = element.second;
+            overflow.push_back(entry);
+        });
+        std::sort(overflow.begin(), overflow.end(),
+                  [](const OverflowEntry& a, const OverflowEntry& b) { return a.key < b.key; });
+
+        header.bucketSlots = buckets.size();
+        header.overflowCount = overflow.size();
+        header.bucketsOffset = snapshot_detail::alignOffset(sizeof(header), 64);
+        header.overflowOffset = snapshot_detail::alignOffset(header.bucketsOffset + buckets.size() * sizeof(Bucket), 64);
+        header.fileBytes = header.overflowOffset + overflow.size() * sizeof(OverflowEntry);
+
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot create snapshot file " + temporary);
+            }
+            const std::vector<char> zeros(64, 0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(zeros.data(), std::streamsize(header.bucketsOffset - sizeof(header)));
+            out.write(reinterpret_cast<const char*>(buckets.data()), std::streamsize(buckets.size() * sizeof(Bucket)));
+            out.write(zeros.data(),
+                      std::streamsize(header.overflowOffset - header.bucketsOffset - buckets.size() * sizeof(Bucket)));
+            out.write(reinterpret_cast<const char*>(overflow.data()),
+                      std::streamsize(overflow.size() * sizeof(OverflowEntry)));
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("Cannot write snapshot file " + temporary);
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot rename snapshot file to " + path);
+        }
+    }
+
+    // Map the snapshot at path; prefault reads the whole file in right away.
+    explicit HopscotchSnapshot(const std::string& path, bool prefault = false, const Hash& hash = Hash())
+        : hash_(hash), data_(nullptr), bytes_(0) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open snapshot file " + path);
+        }
+        struct stat status;
+        if (fstat(fd, &status) != 0 || std::size_t(status.st_size) < sizeof(snapshot_detail::Header)) {
+            ::close(fd);
+            throw std::runtime_error("Snapshot file " + path + " is truncated");
+        }
+        bytes_ = std::size_t(status.st_size);
+        int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+        if (prefault) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void* mapped = mmap(nullptr, bytes_, PROT_READ, flags, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("Cannot map snapshot file " + path);
+        }
+        data_ = static_cast<const char*>(mapped);
+        try {
+            validate(path);
+        } catch (...) {
+            munmap(const_cast<char*>(data_), bytes_);
+            throw;
+        }
+    }
+
+    HopscotchSnapshot(const HopscotchSnapshot&) = delete;
+    HopscotchSnapshot& operator=(const HopscotchSnapshot&) = delete;
+
+    ~HopscotchSnapshot() {
+        munmap(const_cast<char*>(data_), bytes_);
+    }
+
+    std::size_t size() const {
+        return header().size;
+    }
+
+    std::size_t bucketCount() const {
+        return header().bucketCount;
+    }
+
+    std::size_t overflowSize() const {
+        return header().overflowCount;
+    }
+
+    std::size_t fileBytes() const {
+        return bytes_;
+    }
+
+    bool find(const Key& key, Value& value) const {
+        const snapshot_detail::Header& head = header();
+        if (head.bucketCount == 0) {
+            return false;
+        }
+        const Bucket* home = buckets() + (std::size_t(hash_(key)) & (head.bucketCount - 1));
+        uint64_t neighborhood = home->info >> 2;
+        for (const Bucket* bucket = home; neighborhood != 0; bucket++, neighborhood >>= 1) {
+            if ((neighborhood & 1) && bucket->key == key) {
+                value = bucket->value;
+                return true;
+            }
+        }
+        if (home->info & 2) {
+            const OverflowEntry* first = overflow();
+            const OverflowEntry* last = first + head.overflowCount;
+            const OverflowEntry* it = std::lower_bound(
+                first, last, key, [](const OverflowEntry& entry, const Key& k) { return entry.key < k; });
+            if (it != last && it->key == key) {
+                value = it->value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const snapshot_detail::Header& header() const {
+        return *reinterpret_cast<const snapshot_detail::Header*>(data_);
+    }
+
+    const Bucket* buckets() const {
+        return reinterpret_cast<const Bucket*>(data_ + header().bucketsOffset);
+    }
+
+    const OverflowEntry* overflow() const {
+        return reinterpret_cast<const OverflowEntry*>(data_ + header().overflowOffset);
+    }
+
+    void validate(const std::string& path) const {
+        const snapshot_detail::Header& head = header();
+        if (std::memcmp(head.magic, snapshot_detail::MAGIC, sizeof(head.magic)) != 0 ||
+            head.version != snapshot_detail::VERSION) {
+            throw std::runtime_error(path + " is not a hopscotch snapshot");
+        }
+        if (head.keyBytes != sizeof(Key) || head.valueBytes != sizeof(Value) ||
+            head.neighborhoodSize != NeighborhoodSize) {
+            throw std::runtime_error("Snapshot " + path + " was written for other key, value or neighborhood sizes");
+        }
+        const bool powerOfTwo = (head.bucketCount & (head.bucketCount - 1)) == 0;
+        const uint64_t expectedSlots = head.bucketCount == 0 ? 0 : head.bucketCount + NeighborhoodSize - 1;
+        if (!powerOfTwo || head.bucketSlots != expectedSlots || head.fileBytes != bytes_ ||
+            head.bucketsOffset + head.bucketSlots * sizeof(Bucket) > head.overflowOffset ||
+            head.overflowOffset + head.overflowCount * sizeof(OverflowEntry) > bytes_) {
+            throw std::runtime_error("Snapshot " + path + " is corrupt");
+        }
+    }
+
+    Hash hash_;
+    const char* data_;
+    std::size_t bytes_;
+};
+
+#endif
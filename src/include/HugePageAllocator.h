@@ -0,0 +1,156 @@
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/*
+ * Standard allocator backing large arrays with 2 MB pages, so a table of a
+ * few hundred MB needs a few hundred TLB entries instead of tens of thousands
+ * and random probes stop missing the dTLB.
+ *
+ * Requests of at least LARGE_ALLOCATION bytes are rounded up to whole huge
+ * pages and mapped with MAP_HUGETLB from the reserved pool
+ * (/proc/sys/vm/nr_hugepages). When the pool is empty or not configured the
+ * region is mapped normally and marked MADV_HUGEPAGE, so transparent huge
+ * pages back it when the kernel allows (enabled = always or madvise). Smaller
+ * requests, such as std::unordered_map nodes, go to operator new: a huge
+ * page per node would waste memory without improving TLB reach.
+ *
+ * The allocator is stateless, the path of a block follows from its size, so
+ * deallocate() takes the same decision as allocate(). Outside Linux every
+ * request goes to operator new.
+ */
+namespace huge_page_detail {
+
+static const std::size_t HUGE_PAGE_BYTES = std::size_t(2) << 20;
+static const std::size_t LARGE_ALLOCATION = std::size_t(1) << 20;
+
+// Bytes mapped so far per backing, shared by all HugePageAllocator instantiations
+struct Usage {
+    std::atomic<std::size_t> hugetlbBytes{0};
+    std::atomic<std::size_t> madviseBytes{0};
+    std::atomic<std::size_t> hugetlbFailures{0};
+};
+
+inline Usage& usage() {
+    static Usage instance;
+    return instance;
+}
+
+inline std::size_t roundToHugePages(std::size_t bytes) {
+    return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+/*
+ * Anonymous memory of the process the kernel actually backs with transparent
+ * huge pages (AnonHugePages in /proc/self/smaps_rollup), 0 if unavailable.
+ * MAP_HUGETLB pages are not included.
+ */
+inline std::size_t transparentHugePageBytes() {
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string field;
+    while (smaps >> field) {
+        if (field == "AnonHugePages:") {
+            std::size_t kilobytes = 0;
+            smaps >> kilobytes;
+            return kilobytes * 1024;
+        }
+    }
+    return 0;
+}
+
+// Map bytes (a multiple of HUGE_PAGE_BYTES) with the best available backing.
+inline void* mapLarge(std::size_t bytes) {
+#if defined(__linux__)
+#if defined(MAP_HUGETLB)
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+        usage().hugetlbBytes += bytes;
+        return memory;
+    }
+    usage().hugetlbFailures++;
+#endif
+    // Over-map by one huge page so the region can start on a huge page boundary
+    const std::size_t mapped = bytes + HUGE_PAGE_BYTES;
+    char* raw = static_cast<char*>(mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(raw) + HUGE_PAGE_BYTES - 1) &
+                                            ~uintptr_t(HUGE_PAGE_BYTES - 1));
+    if (aligned != raw) {
+        munmap(raw, aligned - raw);
+    }
+    const std::size_t tail = mapped - (aligned - raw) - bytes;
+    if (tail != 0) {
+        munmap(aligned + bytes, tail);
+    }
+#if defined(MADV_HUGEPAGE)
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    usage().madviseBytes += bytes;
+    return aligned;
+#else
+    return ::operator new(bytes);
+#endif
+}
+
+inline void unmapLarge(void* memory, std::size_t bytes) {
+#if defined(__linux__)
+    // Both backings are whole huge pages, so one munmap covers either
+    munmap(memory, bytes);
+#else
+    ::operator delete(memory);
+#endif
+}
+
+} // namespace huge_page_detail
+
+template <typename T>
+class HugePageAllocator {
+public:
+    typedef T value_type;
+
+    HugePageAllocator() noexcept {}
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes < huge_page_detail::LARGE_ALLOCATION) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        return static_cast<T*>(huge_page_detail::mapLarge(huge_page_detail::roundToHugePages(bytes)));
+    }
+
+    void deallocate(T* pointer, std::size_t n) noexcept {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes < huge_page_detail::LARGE_ALLOCATION) {
+            ::operator delete(pointer);
+            return;
+        }
+        huge_page_detail::unmapLarge(pointer, huge_page_detail::roundToHugePages(bytes));
+    }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U>&) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const HugePageAllocator<U>&) const noexcept {
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef INCREMENTAL_HOPSCOTCH_MAP_H
+#define INCREMENTAL_HOPSCOTCH_MAP_H
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "tsl/hopscotch_map.h"
+
+/*
+ * tsl::hopscotch_map with amortized resizing.
+ *
+ * A plain hopscotch_map grows inside the insert that crosses the load
+ * threshold: rehash_impl allocates the larger bucket array and moves every
+ * element before that insert returns. Here the insert that would trigger the
+ * rehash instead retires the full table as the draining table and starts an
+ * empty table with twice the buckets. Every following insert moves at most
+ * migrationStep elements from the draining table to the current one, so the
+ * cost of the resize is spread over the next inserts.
+ *
+ * During a migration inserts only write to the current table and lookups
+ * try it before the draining one, so a key written again during the
+ * migration shadows its old copy, which is dropped when the migration
+ * reaches it. Lookups never migrate, so const lookups stay free of writes;
+ * migrate() lets a caller spend spare time on the migration explicitly.
+ *
+ * The migration always ends before the current table reaches its own
+ * threshold: the current table has twice the buckets of the draining one,
+ * and with a migrationStep of 2 or more the draining elements are moved
+ * within half as many inserts. What remains proportional to the table in one
+ * insert is allocating the new bucket array and releasing the old one. A
+ * hopscotch displacement failure in the current table can still trigger
+ * tsl's own rehash, as in the plain map.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class IncrementalHopscotchMap {
+public:
+    typedef tsl::hopscotch_map<Key, Value, Hash> Table;
+
+    // Tables smaller than this resize in one step, the pause is negligible
+    static const std::size_t MIN_INCREMENTAL_BUCKETS = 1024;
+
+    explicit IncrementalHopscotchMap(std::size_t migrationStep = 8)
+        : migrationStep_(migrationStep < 2 ? 2 : migrationStep), shadowed_(0), migrating_(false), resizes_(0) {}
+
+    std::size_t size() const {
+        return current_.size() + (migrating_ ? draining_.size() - shadowed_ : 0);
+    }
+
+    std::size_t bucketCount() const {
+        return current_.bucket_count();
+    }
+
+    bool migrating() const {
+        return migrating_;
+    }
+
+    // Elements still waiting in the draining table
+    std::size_t pendingMigration() const {
+        return migrating_ ? draining_.size() : 0;
+    }
+
+    std::size_t resizes() const {
+        return resizes_;
+    }
+
+    std::size_t migrationStep() const {
+        return migrationStep_;
+    }
+
+    const Table& currentTable() const {
+        return current_;
+    }
+
+    const Value* find(const Key& key) const {
+        auto it = current_.find(key);
+        if (it != current_.end()) {
+            return &it->second;
+        }
+        if (migrating_) {
+            auto old = draining_.find(key);
+            if (old != draining_.end()) {
+                return &old->second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Insert key or overwrite its value.
+    void insert(const Key& key, const Value& value) {
+        if (migrating_) {
+            if (current_.find(key) == current_.end() && draining_.find(key) != draining_.end()) {
+                shadowed_++;
+            }
+        } else if (current_.bucket_count() >= MIN_INCREMENTAL_BUCKETS &&
+                   current_.size() >= std::size_t(float(current_.bucket_count()) * current_.max_load_factor()) &&
+                   current_.find(key) == current_.end()) {
+            startMigration();
+        }
+        current_[key] = value;
+        if (migrating_) {
+            migrate(migrationStep_);
+        }
+    }
+
+    // Move up to elements entries of the draining table, finishing the migration if it empties.
+    void migrate(std::size_t elements) {
+        if (!migrating_) {
+            return;
+        }
+        for (std::size_t i = 0; i < elements && cursor_ != draining_.end(); i++) {
+            // A key written during the migration keeps its newer value
+            if (!current_.insert(std::make_pair(cursor_->first, cursor_->second)).second) {
+                shadowed_--;
+            }
+            cursor_ = draining_.erase(cursor_);
+        }
+        if (cursor_ == draining_.end()) {
+            Table().swap(draining_);
+            migrating_ = false;
+        }
+    }
+
+private:
+    void startMigration() {
+        draining_.swap(current_);
+        current_ = Table();
+        current_.rehash(draining_.bucket_count() * 2);
+        cursor_ = draining_.begin();
+        shadowed_ = 0;
+        migrating_ = true;
+        resizes_++;
+    }
+
+    std::size_t migrationStep_;
+    Table current_;
+    Table draining_;
+    // Next element of draining_ to move. Only the migration erases from
+    // draining_, tsl iterators do not survive erasing other elements.
+    typename Table::iterator cursor_;
+    // Keys of draining_ that were written again and also live in current_
+    std::size_t shadowed_;
+    bool migrating_;
+    std::size_t resizes_;
+};
+
+#endif
@@ -0,0 +1,359 @@
+#ifndef INTERLEAVED_LOOKUP_H
+#define INTERLEAVED_LOOKUP_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <new>
+#include <unordered_map>
+#include <utility>
+
+#include "BPlusTree.h"
+#include "tsl/hopscotch_map.h"
+
+/*
+ * Lookups written as coroutines and interleaved to hide memory latency
+ * (Psaropoulos et al., "Interleaving with coroutines", VLDB 2017).
+ *
+ * A lookup coroutine prefetches the next node or bucket it needs and
+ * suspends before reading it. The scheduler keeps a group of lookups in
+ * flight and resumes them round-robin, so while one lookup waits for its
+ * cache line the others issue their own prefetches and by the time it is
+ * resumed the line is usually there. Unlike a hand-written prefetch pipeline
+ * (find_batch of tsl::hopscotch_map) this also works for pointer chasing,
+ * where the next address is only known after the previous load: every level
+ * of a tree descent becomes one suspension.
+ *
+ * Coroutine frames are recycled through a per-thread free list, a lookup
+ * costs a few resumes and no allocation once the first group has run.
+ */
+namespace interleave_detail {
+
+// Lookups kept in flight by default, enough to cover a DRAM miss
+static const std::size_t DEFAULT_GROUP = 16;
+static const std::size_t MAX_GROUP = 64;
+static const std::size_t CACHE_LINE = 64;
+
+/*
+ * Free list of coroutine frames of one size. All lookups of a batch come
+ * from the same coroutine and have the same frame size; a frame of another
+ * size empties the list and the pool switches to that size.
+ */
+class FramePool {
+public:
+    FramePool() : frameBytes_(0), free_(nullptr) {}
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    ~FramePool() {
+        release();
+    }
+
+    void* allocate(std::size_t bytes) {
+        if (free_ != nullptr && bytes == frameBytes_) {
+            FreeFrame* frame = free_;
+            free_ = frame->next;
+            return frame;
+        }
+        return ::operator new(bytes < sizeof(FreeFrame) ? sizeof(FreeFrame) : bytes);
+    }
+
+    void deallocate(void* memory, std::size_t bytes) {
+        if (bytes != frameBytes_) {
+            release();
+            frameBytes_ = bytes;
+        }
+        FreeFrame* frame = static_cast<FreeFrame*>(memory);
+        frame->next = free_;
+        free_ = frame;
+    }
+
+private:
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+
+    void release() {
+        while (free_ != nullptr) {
+            FreeFrame* frame = free_;
+            free_ = frame->next;
+            ::operator delete(frame);
+        }
+    }
+
+    std::size_t frameBytes_;
+    FreeFrame* free_;
+};
+
+inline FramePool& framePool() {
+    thread_local FramePool pool;
+    return pool;
+}
+
+inline void prefetchLines(const void* address, std::size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    const char* line = static_cast<const char*>(address);
+    for (std::size_t offset = 0; offset < bytes; offset += CACHE_LINE) {
+        __builtin_prefetch(line + offset);
+    }
+#else
+    (void)address;
+    (void)bytes;
+#endif
+}
+
+} // namespace interleave_detail
+
+/*
+ * Coroutine type of a lookup. It starts suspended, runs until its next
+ * co_await prefetchAndSwitch() on every resume() and keeps the value of
+ * co_return until it is destroyed.
+ */
+template <typename Result>
+class LookupTask {
+public:
+    struct promise_type {
+        Result result;
+
+        LookupTask get_return_object() {
+            return LookupTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        void return_value(Result value) {
+            result = value;
+        }
+
+        // Lookups do not throw, an exception cannot reach the scheduler
+        void unhandled_exception() {
+            std::terminate();
+        }
+
+        static void* operator new(std::size_t bytes) {
+            return interleave_detail::framePool().allocate(bytes);
+        }
+
+        static void operator delete(void* memory, std::size_t bytes) {
+            interleave_detail::framePool().deallocate(memory, bytes);
+        }
+    };
+
+    LookupTask() : handle_(nullptr) {}
+
+    LookupTask(LookupTask&& other) noexcept : handle_(other.handle_) {
+        other.handle_ = nullptr;
+    }
+
+    LookupTask& operator=(LookupTask&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    LookupTask(const LookupTask&) = delete;
+    LookupTask& operator=(const LookupTask&) = delete;
+
+    ~LookupTask() {
+        destroy();
+    }
+
+    bool done() const {
+        return handle_.done();
+    }
+
+    void resume() {
+        handle_.resume();
+    }
+
+    const Result& result() const {
+        return handle_.promise().result;
+    }
+
+private:
+    explicit LookupTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void destroy() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Awaitable issuing the prefetch and handing control back to the scheduler
+struct PrefetchAndSwitch {
+    const void* address;
+    std::size_t bytes;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<>) const noexcept {
+        interleave_detail::prefetchLines(address, bytes);
+    }
+
+    void await_resume() const noexcept {}
+};
+
+inline PrefetchAndSwitch prefetchAndSwitch(const void* address, std::size_t bytes = interleave_detail::CACHE_LINE) {
+    return PrefetchAndSwitch{address, bytes};
+}
+
+/*
+ * Run count lookups with up to group of them in flight. makeLookup(i)
+ * creates the lookup of index i, consume(i, result) receives its result as
+ * soon as it completes; results arrive out of order.
+ */
+template <typename Result, class MakeLookup, class Consume>
+void interleaveLookups(std::size_t count, std::size_t group, MakeLookup makeLookup, Consume consume) {
+    if (group == 0) {
+        group = 1;
+    }
+    if (group > interleave_detail::MAX_GROUP) {
+        group = interleave_detail::MAX_GROUP;
+    }
+    LookupTask<Result> slots[interleave_detail::MAX_GROUP];
+    std::size_t indices[interleave_detail::MAX_GROUP];
+    std::size_t next = 0;
+    std::size_t active = 0;
+    for (; active < group && next < count; active++, next++) {
+        slots[active] = makeLookup(next);
+        indices[active] = next;
+    }
+    const std::size_t used = active;
+    while (active > 0) {
+        for (std::size_t s = 0; s < used; s++) {
+            LookupTask<Result>& task = slots[s];
+            if (indices[s] == count) {
+                continue;
+            }
+            task.resume();
+            if (!task.done()) {
+                continue;
+            }
+            consume(indices[s], task.result());
+            if (next < count) {
+                task = makeLookup(next);
+                indices[s] = next++;
+            } else {
+                task = LookupTask<Result>();
+                indices[s] = count;
+                active--;
+            }
+        }
+    }
+}
+
+// Home bucket prefetched before the neighborhood search
+template <class Key, class Value, class Hash, class KeyEqual, class Allocator, unsigned int NeighborhoodSize,
+          bool StoreHash, class GrowthPolicy, class OverflowContainer, bool CompactBuckets>
+LookupTask<const Value*> interleavedFind(const tsl::hopscotch_map<Key, Value, Hash, KeyEqual, Allocator, NeighborhoodSize,
+                                                                  StoreHash, GrowthPolicy, OverflowContainer,
+                                                                  CompactBuckets>& map,
+                                         Key key) {
+    const std::size_t hash = map.hash_function()(key);
+    co_await prefetchAndSwitch(map.home_bucket_address(hash));
+    auto it = map.find(key, hash);
+    co_return it == map.end() ? nullptr : &it->second;
+}
+
+/*
+ * One suspension per node of the bucket chain. The bucket array slot is not
+ * exposed by the standard interface, so reaching the chain head still
+ * stalls; the nodes of the chain are prefetched.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Allocator>
+LookupTask<const Value*> interleavedFind(const std::unordered_map<Key, Value, Hash, KeyEqual, Allocator>& map,
+                                         Key key) {
+    const std::size_t bucket = map.bucket(key);
+    for (auto it = map.begin(bucket); it != map.end(bucket); ++it) {
+        co_await prefetchAndSwitch(&*it, sizeof(*it));
+        if (map.key_eq()(it->first, key)) {
+            co_return &it->second;
+        }
+    }
+    co_return nullptr;
+}
+
+/*
+ * One suspension per level of the red-black tree. The standard interface has
+ * no way to descend the tree a node at a time, so this walks the libstdc++
+ * nodes directly (the same search as lower_bound); with another library the
+ * lookup runs as a plain find without suspending.
+ */
+template <class Key, class Value, class Compare, class Allocator>
+LookupTask<const Value*> interleavedFind(const std::map<Key, Value, Compare, Allocator>& map, Key key) {
+#if defined(__GLIBCXX__)
+    typedef std::_Rb_tree_node<typename std::map<Key, Value, Compare, Allocator>::value_type> Node;
+    const Compare less = map.key_comp();
+    const std::_Rb_tree_node_base* header = map.end()._M_node;
+    const std::_Rb_tree_node_base* candidate = header;
+    const std::_Rb_tree_node_base* node = header->_M_parent;
+    while (node != nullptr) {
+        co_await prefetchAndSwitch(node, sizeof(Node));
+        if (!less(static_cast<const Node*>(node)->_M_valptr()->first, key)) {
+            candidate = node;
+            node = node->_M_left;
+        } else {
+            node = node->_M_right;
+        }
+    }
+    if (candidate == header || less(key, static_cast<const Node*>(candidate)->_M_valptr()->first)) {
+        co_return nullptr;
+    }
+    co_return &static_cast<const Node*>(candidate)->_M_valptr()->second;
+#else
+    auto it = map.find(key);
+    co_return it == map.end() ? nullptr : &it->second;
+#endif
+}
+
+/*
+ * One suspension per level of the B+tree. Only the first lines of a node
+ * are prefetched: a 4 KB node is mostly children pointers, of which the
+ * search reads one.
+ */
+template <class Key, class Value, std::size_t NodeBytes>
+LookupTask<const Value*> interleavedFind(const BPlusTree<Key, Value, NodeBytes>& tree, Key key) {
+    typedef BPlusTree<Key, Value, NodeBytes> Tree;
+    const std::size_t prefetchBytes = NodeBytes < 256 ? NodeBytes : 256;
+    typename Tree::NodeHandle node = tree.rootNode();
+    if (node == nullptr) {
+        co_return nullptr;
+    }
+    co_await prefetchAndSwitch(node, prefetchBytes);
+    while (!Tree::isLeaf(node)) {
+        node = Tree::childFor(node, key);
+        co_await prefetchAndSwitch(node, prefetchBytes);
+    }
+    co_return Tree::findInLeaf(node, key);
+}
+
+/*
+ * Look up count keys of container with group lookups in flight, values[i]
+ * is set to the value of keys[i] or nullptr.
+ */
+template <class Container, class Key, class Value>
+void interleavedFindBatch(const Container& container, const Key* keys, std::size_t count, const Value** values,
+                          std::size_t group = interleave_detail::DEFAULT_GROUP) {
+    interleaveLookups<const Value*>(
+        count, group, [&](std::size_t i) { return interleavedFind(container, keys[i]); },
+        [values](std::size_t i, const Value* value) { values[i] = value; });
+}
+
+#endif
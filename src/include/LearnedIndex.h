@@ -0,0 +1,256 @@
+#ifndef LEARNED_INDEX_H
+#define LEARNED_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "tsl/hopscotch_map.h"
+
+/*
+ * Two-stage recursive model index (RMI) over a sorted key array.
+ *
+ * The root is a linear model predicting the position of a key in the sorted
+ * array; the prediction selects one of the leaf models. Each leaf is a linear
+ * model fitted on the keys routed to it, together with the minimum and
+ * maximum prediction error seen at build time. A lookup evaluates two models
+ * and then binary searches only the [prediction - maxUnder, prediction +
+ * maxOver] window (the "last mile").
+ *
+ * The index is static: keys inserted after build() go into a small hopscotch
+ * delta buffer which is merged and the models retrained once it grows past a
+ * fraction of the indexed keys.
+ */
+template <typename Key, typename Value>
+class RecursiveModelIndex {
+    static_assert(std::is_arithmetic<Key>::value, "RecursiveModelIndex needs numeric keys.");
+
+    struct LinearModel {
+        double slope;
+        double intercept;
+
+        double predict(Key key) const {
+            return slope * double(key) + intercept;
+        }
+    };
+
+    struct LeafModel {
+        LinearModel model;
+        // Bounds of (true position - predicted position) over the keys of the leaf
+        int32_t minError;
+        int32_t maxError;
+    };
+
+public:
+    struct Stats {
+        std::size_t leafModels;
+        std::size_t modelBytes;
+        double averageError;
+        std::size_t maxSearchWindow;
+        double averageSearchWindow;
+        std::size_t deltaSize;
+    };
+
+    explicit RecursiveModelIndex(std::size_t keysPerLeafModel = 32)
+        : keysPerLeafModel_(std::max<std::size_t>(1, keysPerLeafModel)), averageError_(0) {
+        root_.slope = 0;
+        root_.intercept = 0;
+    }
+
+    std::size_t size() const {
+        return keys_.size() + delta_.size();
+    }
+
+    /*
+     * Build the index from unsorted pairs, replacing the current content. If a
+     * key appears several times the last value wins.
+     */
+    void build(const std::vector<Key>& keys, const std::vector<Value>& values) {
+        std::vector<std::size_t> order(keys.size());
+        std::iota(order.begin(), order.end(), std::size_t(0));
+        std::stable_sort(order.begin(), order.end(),
+                         [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+
+        keys_.clear();
+        values_.clear();
+        keys_.reserve(keys.size());
+        values_.reserve(keys.size());
+        for (std::size_t i : order) {
+            if (!keys_.empty() && keys_.back() == keys[i]) {
+                values_.back() = values[i];
+            } else {
+                keys_.push_back(keys[i]);
+                values_.push_back(values[i]);
+            }
+        }
+        delta_.clear();
+        train();
+    }
+
+    const Value* find(const Key& key) const {
+        if (!keys_.empty()) {
+            const std::size_t pos = search(key);
+            if (pos < keys_.size() && keys_[pos] == key) {
+                return &values_[pos];
+            }
+        }
+        if (!delta_.empty()) {
+            auto it = delta_.find(key);
+            if (it != delta_.end()) {
+                return &it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Insert key or overwrite its value. New keys go to the delta buffer.
+    void insert(const Key& key, const Value& value) {
+        if (!keys_.empty()) {
+            const std::size_t pos = search(key);
+            if (pos < keys_.size() && keys_[pos] == key) {
+                values_[pos] = value;
+                return;
+            }
+        }
+        delta_[key] = value;
+        const std::size_t mergeThreshold = keys_.size() / DELTA_MERGE_FRACTION;
+        if (delta_.size() >= MIN_DELTA_MERGE && delta_.size() >= mergeThreshold) {
+            mergeDelta();
+        }
+    }
+
+    Stats stats() const {
+        Stats result;
+        result.leafModels = leaves_.size();
+        result.modelBytes = sizeof(root_) + leaves_.size() * sizeof(LeafModel);
+        result.averageError = averageError_;
+        result.maxSearchWindow = 0;
+        double windowSum = 0;
+        for (const LeafModel& leaf : leaves_) {
+            const std::size_t window = std::size_t(leaf.maxError - leaf.minError) + 1;
+            result.maxSearchWindow = std::max(result.maxSearchWindow, window);
+            windowSum += double(window);
+        }
+        result.averageSearchWindow = leaves_.empty() ? 0 : windowSum / double(leaves_.size());
+        result.deltaSize = delta_.size();
+        return result;
+    }
+
+private:
+    static const std::size_t MIN_DELTA_MERGE = 1024;
+    static const std::size_t DELTA_MERGE_FRACTION = 8;
+
+    std::size_t leafFor(Key key) const {
+        const double predicted = root_.predict(key) * double(leaves_.size()) / double(keys_.size());
+        if (!(predicted > 0)) {
+            return 0;
+        }
+        if (predicted >= double(leaves_.size() - 1)) {
+            return leaves_.size() - 1;
+        }
+        return std::size_t(predicted);
+    }
+
+    // Position of key in keys_ if it is indexed, an unspecified position otherwise.
+    std::size_t search(Key key) const {
+        const LeafModel& leaf = leaves_[leafFor(key)];
+        const double predicted = std::floor(leaf.model.predict(key));
+        const double lo = std::max(0.0, predicted + leaf.minError);
+        const double hi = std::min(double(keys_.size()), predicted + leaf.maxError + 1);
+        if (!(lo < hi)) {
+            // Keys outside the range of the leaf, the window is empty
+            return keys_.size();
+        }
+        auto first = keys_.begin() + std::ptrdiff_t(lo);
+        auto last = keys_.begin() + std::ptrdiff_t(hi);
+        return std::size_t(std::lower_bound(first, last, key) - keys_.begin());
+    }
+
+    static LinearModel fit(const std::vector<Key>& keys, std::size_t begin, std::size_t end) {
+        LinearModel model;
+        const std::size_t count = end - begin;
+        if (count <= 1) {
+            model.slope = 0;
+            model.intercept = double(begin);
+            return model;
+        }
+        // Least squares on (key, position), centered to limit rounding errors
+        double meanKey = 0;
+        double meanPos = 0;
+        for (std::size_t i = begin; i < end; i++) {
+            meanKey += double(keys[i]);
+            meanPos += double(i);
+        }
+        meanKey /= double(count);
+        meanPos /= double(count);
+        double covariance = 0;
+        double variance = 0;
+        for (std::size_t i = begin; i < end; i++) {
+            const double dk = double(keys[i]) - meanKey;
+            covariance += dk * (double(i) - meanPos);
+            variance += dk * dk;
+        }
+        model.slope = variance > 0 ? covariance / variance : 0;
+        model.intercept = meanPos - model.slope * meanKey;
+        return model;
+    }
+
+    void train() {
+        leaves_.clear();
+        averageError_ = 0;
+        if (keys_.empty()) {
+            return;
+        }
+
+        root_ = fit(keys_, 0, keys_.size());
+        leaves_.resize(std::max<std::size_t>(1, keys_.size() / keysPerLeafModel_));
+
+        // The root model is monotonic, the keys of a leaf are a contiguous run
+        std::size_t begin = 0;
+        double errorSum = 0;
+        for (std::size_t leafIndex = 0; leafIndex < leaves_.size(); leafIndex++) {
+            std::size_t end = begin;
+            while (end < keys_.size() && leafFor(keys_[end]) == leafIndex) {
+                end++;
+            }
+
+            LeafModel& leaf = leaves_[leafIndex];
+            leaf.model = fit(keys_, begin, end);
+            leaf.minError = 0;
+            leaf.maxError = 0;
+            for (std::size_t i = begin; i < end; i++) {
+                const double predicted = std::floor(leaf.model.predict(keys_[i]));
+                const double error = double(i) - predicted;
+                leaf.minError = std::min(leaf.minError, int32_t(error));
+                leaf.maxError = std::max(leaf.maxError, int32_t(error));
+                errorSum += std::fabs(error);
+            }
+            begin = end;
+        }
+        averageError_ = errorSum / double(keys_.size());
+    }
+
+    void mergeDelta() {
+        std::vector<Key> keys(keys_);
+        std::vector<Value> values(values_);
+        for (auto it = delta_.begin(); it != delta_.end(); ++it) {
+            keys.push_back(it->first);
+            values.push_back(it->second);
+        }
+        build(keys, values);
+    }
+
+    std::size_t keysPerLeafModel_;
+    std::vector<Key> keys_;
+    std::vector<Value> values_;
+    LinearModel root_;
+    std::vector<LeafModel> leaves_;
+    double averageError_;
+    tsl::hopscotch_map<Key, Value> delta_;
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef LOCK_FREE_HASH_TABLE_H
+#define LOCK_FREE_HASH_TABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+/*
+ * Lock-free linear-probing hash table for integer keys and values of at most
+ * 32 bits.
+ *
+ * Every slot is one std::atomic<uint64_t> holding the key in the high half and
+ * the value in the low half, so a pair is always read and written as a unit.
+ * Inserting a new key claims an empty slot with compare-and-swap, updating a
+ * key swaps its slot again; lookups are plain acquire loads along the probe
+ * sequence. Keys are never removed.
+ *
+ * The key whose 32-bit image is 0x80000000 (INT_MIN for int) marks empty
+ * slots and the same value image (MOVED) marks slots frozen by a migration,
+ * so neither can be stored.
+ *
+ * Resizing is cooperative and incremental. Once a table is 3/4 full a table
+ * twice as large is chained after it, and every insert then migrates one
+ * chunk of MIGRATION_CHUNK_SLOTS slots: each slot is copied to the next table
+ * and then frozen with a CAS, which fails and retries if a writer updated the
+ * pair in between. Operations meeting a frozen slot continue in the next
+ * table. The thread finishing the last chunk publishes the next table; old
+ * tables stay allocated until the map is destroyed since readers may still
+ * be probing them. Readers never help migrating.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class LockFreeHashTable {
+    static_assert(std::is_integral<Key>::value && sizeof(Key) <= 4, "LockFreeHashTable needs keys of at most 32 bits.");
+    static_assert(std::is_integral<Value>::value && sizeof(Value) <= 4,
+                  "LockFreeHashTable needs values of at most 32 bits.");
+
+public:
+    static const std::size_t MIGRATION_CHUNK_SLOTS = 1024;
+
+    explicit LockFreeHashTable(std::size_t initialCapacity = 1024, const Hash& hash = Hash()) : hash_(hash) {
+        std::size_t capacity = 16;
+        while (capacity < initialCapacity) {
+            capacity *= 2;
+        }
+        first_ = new Table(capacity);
+        table_.store(first_, std::memory_order_release);
+    }
+
+    LockFreeHashTable(const LockFreeHashTable&) = delete;
+    LockFreeHashTable& operator=(const LockFreeHashTable&) = delete;
+
+    ~LockFreeHashTable() {
+        Table* table = first_;
+        while (table != nullptr) {
+            Table* next = table->next.load(std::memory_order_relaxed);
+            delete table;
+            table = next;
+        }
+    }
+
+    std::size_t capacity() const {
+        return table_.load(std::memory_order_acquire)->capacity;
+    }
+
+    // Keys claimed in the current table, exact once no migration is running
+    std::size_t size() const {
+        return table_.load(std::memory_order_acquire)->count.load(std::memory_order_relaxed);
+    }
+
+    std::size_t memoryBytes() const {
+        return capacity() * sizeof(std::atomic<uint64_t>);
+    }
+
+    // Number of tables replaced by a migration
+    std::size_t migrations() const {
+        std::size_t result = 0;
+        for (const Table* table = first_; table != table_.load(std::memory_order_acquire);
+             table = table->next.load(std::memory_order_acquire)) {
+            result++;
+        }
+        return result;
+    }
+
+    bool find(const Key& key, Value& value) const {
+        const uint32_t keyField = keyFieldOf(key);
+        const Table* table = table_.load(std::memory_order_acquire);
+        for (;;) {
+            std::size_t index = table->home(hash_(key));
+            bool forward = false;
+            for (std::size_t probes = 0; probes < table->capacity; probes++) {
+                const uint64_t slot = table->slots[index].load(std::memory_order_acquire);
+                const uint32_t slotKey = uint32_t(slot >> 32);
+                if (slotKey == keyField || slotKey == EMPTY) {
+                    if (uint32_t(slot) == MOVED) {
+                        forward = true;
+                        break;
+                    }
+                    if (slotKey == EMPTY) {
+                        return false;
+                    }
+                    value = Value(UnsignedValue(uint32_t(slot)));
+                    return true;
+                }
+                index = (index + 1) & table->mask;
+            }
+            const Table* next = table->next.load(std::memory_order_acquire);
+            if (!forward && next == nullptr) {
+                return false;
+            }
+            table = next;
+        }
+    }
+
+    // Insert key or overwrite its value.
+    void insert(const Key& key, const Value& value) {
+        if (keyFieldOf(key) == EMPTY || valueFieldOf(value) == MOVED) {
+            throw std::invalid_argument("LockFreeHashTable reserves the key and value with 32-bit image 0x80000000.");
+        }
+        Table* current = table_.load(std::memory_order_acquire);
+        if (current->next.load(std::memory_order_acquire) != nullptr) {
+            migrateChunk(current);
+        }
+        upsert(current, hash_(key), pack(keyFieldOf(key), valueFieldOf(value)));
+    }
+
+private:
+    typedef typename std::make_unsigned<Key>::type UnsignedKey;
+    typedef typename std::make_unsigned<Value>::type UnsignedValue;
+
+    static const uint32_t EMPTY = 0;
+    static const uint32_t MOVED = 0x80000000U;
+
+    enum UpsertResult { DONE, FORWARD, FULL };
+
+    struct Table {
+        std::size_t capacity;
+        std::size_t mask;
+        unsigned shift;
+        std::atomic<uint64_t>* slots;
+        std::atomic<std::size_t> count;
+        std::atomic<Table*> next;
+        std::size_t chunkCount;
+        std::atomic<std::size_t> chunkCursor;
+        std::atomic<std::size_t> chunksDone;
+
+        explicit Table(std::size_t capacity_)
+            : capacity(capacity_), mask(capacity_ - 1), shift(64), slots(new std::atomic<uint64_t>[capacity_]),
+              count(0), next(nullptr), chunkCount((capacity_ + MIGRATION_CHUNK_SLOTS - 1) / MIGRATION_CHUNK_SLOTS),
+              chunkCursor(0), chunksDone(0) {
+            for (std::size_t c = capacity; c > 1; c >>= 1) {
+                shift--;
+            }
+            for (std::size_t i = 0; i < capacity; i++) {
+                slots[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        ~Table() {
+            delete[] slots;
+        }
+
+        // Fibonacci hashing so that identity hashes of consecutive keys spread
+        std::size_t home(std::size_t hash) const {
+            return shift >= 64 ? 0 : std::size_t((uint64_t(hash) * 0x9e3779b97f4a7c15ULL) >> shift);
+        }
+    };
+
+    // Empty slots are all-zero, so the key image is stored with its top bit flipped
+    static uint32_t keyFieldOf(const Key& key) {
+        return uint32_t(UnsignedKey(key)) ^ 0x80000000U;
+    }
+
+    static uint32_t valueFieldOf(const Value& value) {
+        return uint32_t(UnsignedValue(value));
+    }
+
+    static uint64_t pack(uint32_t keyField, uint32_t valueField) {
+        return (uint64_t(keyField) << 32) | valueField;
+    }
+
+    // Insert or overwrite a packed pair, following the chain of tables.
+    void upsert(Table* table, std::size_t hash, uint64_t pair) {
+        for (;;) {
+            const UpsertResult result = tryUpsert(table, hash, pair);
+            if (result == DONE) {
+                return;
+            }
+            if (result == FULL) {
+                // No free slot left: finish the migration of this table before moving on
+                startMigration(table);
+                while (table->chunksDone.load() < table->chunkCount) {
+                    if (!migrateChunk(table)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            table = table->next.load(std::memory_order_acquire);
+        }
+    }
+
+    UpsertResult tryUpsert(Table* table, std::size_t hash, uint64_t pair) {
+        const uint32_t keyField = uint32_t(pair >> 32);
+        std::size_t index = table->home(hash);
+        for (std::size_t probes = 0; probes < table->capacity; probes++) {
+            uint64_t slot = table->slots[index].load(std::memory_order_acquire);
+            for (;;) {
+                const uint32_t slotKey = uint32_t(slot >> 32);
+                if (slotKey != keyField && slotKey != EMPTY) {
+                    break;
+                }
+                if (uint32_t(slot) == MOVED) {
+                    return FORWARD;
+                }
+                // On failure slot is reloaded and examined again
+                if (table->slots[index].compare_exchange_weak(slot, pair, std::memory_order_acq_rel,
+                                                              std::memory_order_acquire)) {
+                    if (slotKey == EMPTY && table->count.fetch_add(1, std::memory_order_relaxed) + 1 >=
+                                                table->capacity / 4 * 3) {
+                        startMigration(table);
+                    }
+                    return DONE;
+                }
+            }
+            index = (index + 1) & table->mask;
+        }
+        return FULL;
+    }
+
+    static void startMigration(Table* table) {
+        if (table->next.load(std::memory_order_acquire) != nullptr) {
+            return;
+        }
+        Table* grown = new Table(table->capacity * 2);
+        Table* expected = nullptr;
+        if (!table->next.compare_exchange_strong(expected, grown, std::memory_order_acq_rel)) {
+            delete grown;
+        }
+    }
+
+    // Copy and freeze one unclaimed chunk of table; false if none is left.
+    bool migrateChunk(Table* table) {
+        const std::size_t chunk = table->chunkCursor.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= table->chunkCount) {
+            return false;
+        }
+        Table* next = table->next.load(std::memory_order_acquire);
+        const std::size_t end = std::min(table->capacity, (chunk + 1) * MIGRATION_CHUNK_SLOTS);
+        for (std::size_t index = chunk * MIGRATION_CHUNK_SLOTS; index < end; index++) {
+            uint64_t slot = table->slots[index].load(std::memory_order_acquire);
+            for (;;) {
+                const uint32_t slotKey = uint32_t(slot >> 32);
+                if (slotKey != EMPTY) {
+                    // Only this thread writes the key downstream until the slot is frozen
+                    upsert(next, hash_(Key(UnsignedKey(slotKey ^ 0x80000000U))), slot);
+                }
+                if (table->slots[index].compare_exchange_weak(slot, pack(slotKey, MOVED), std::memory_order_acq_rel,
+                                                              std::memory_order_acquire)) {
+                    break;
+                }
+            }
+        }
+        if (table->chunksDone.fetch_add(1) + 1 == table->chunkCount) {
+            publish(table);
+        }
+        return true;
+    }
+
+    /*
+     * Make the table after a fully migrated one current. A table may finish
+     * migrating before its predecessor does, so keep advancing while the new
+     * current table is itself fully migrated.
+     */
+    void publish(Table* table) {
+        for (;;) {
+            Table* expected = table;
+            Table* next = table->next.load();
+            if (!table_.compare_exchange_strong(expected, next)) {
+                return;
+            }
+            if (next->next.load() == nullptr || next->chunksDone.load() < next->chunkCount) {
+                return;
+            }
+            table = next;
+        }
+    }
+
+    Hash hash_;
+    std::atomic<Table*> table_;
+    // First table of the chain, every later table hangs off its next pointer
+    Table* first_;
+};
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef NODE_ALLOCATOR_H
+#define NODE_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Standard allocators for node-based containers (std::map, std::unordered_map)
+ * that take the nodes out of malloc. One insert into these containers is one
+ * small allocation, so with std::allocator their insert time is largely the
+ * time of malloc and their nodes end up wherever the heap had a hole.
+ *  - ArenaAllocator: a bump pointer over chunks of growing size. Allocating is
+ *    an add and a compare, deallocating does nothing; the memory comes back
+ *    when the last allocator sharing the arena (the container and all its
+ *    rebound copies) goes away. Nodes inserted one after the other are
+ *    adjacent in memory. Suits tables that only grow.
+ *  - PoolAllocator: one free list per 16-byte size class, refilled from an
+ *    arena. Freed nodes are reused by the next allocation of their class, so
+ *    erase-heavy tables stay bounded, at the cost of a pop and a push.
+ *
+ * Requests larger than SMALL_ALLOCATION bytes, such as the bucket arrays of
+ * std::unordered_map, are not nodes and go to operator new; as with
+ * HugePageAllocator the path of a block follows from its size. Copies and
+ * rebinds of an allocator share its arena or pool, allocators compare equal
+ * when they share it. Neither is thread safe: a table shared between threads
+ * must already serialize its inserts.
+ */
+namespace node_allocator_detail {
+
+static const std::size_t SMALL_ALLOCATION = 256;
+static const std::size_t FIRST_CHUNK_BYTES = std::size_t(4) << 10;
+static const std::size_t MAX_CHUNK_BYTES = std::size_t(1) << 20;
+static const std::size_t POOL_GRANULE = 16;
+
+inline void* allocateLarge(std::size_t bytes, std::size_t& largeBytes) {
+    void* memory = ::operator new(bytes);
+    largeBytes += bytes;
+    return memory;
+}
+
+inline void deallocateLarge(void* memory, std::size_t bytes, std::size_t& largeBytes) noexcept {
+    ::operator delete(memory);
+    largeBytes -= bytes;
+}
+
+// Bump-pointer allocation over chunks doubling from 4 KB up to 1 MB
+class Arena {
+public:
+    Arena() {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        for (char* chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+    }
+
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (next_ == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(end_)) {
+            addChunk(bytes + alignment);
+            aligned = (reinterpret_cast<uintptr_t>(next_) + alignment - 1) & ~uintptr_t(alignment - 1);
+        }
+        next_ = reinterpret_cast<char*>(aligned + bytes);
+        usedBytes_ += bytes;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Bytes handed out, bytes reserved in chunks, number of chunks
+    std::size_t usedBytes() const { return usedBytes_; }
+    std::size_t reservedBytes() const { return reservedBytes_; }
+    std::size_t chunks() const { return chunks_.size(); }
+
+    // Memory of requests above SMALL_ALLOCATION still allocated
+    std::size_t largeBytes = 0;
+
+private:
+    // The remainder of the current chunk is abandoned
+    void addChunk(std::size_t minBytes) {
+        const std::size_t bytes = std::max(nextChunkBytes_, minBytes);
+        chunks_.reserve(chunks_.size() + 1);
+        next_ = static_cast<char*>(::operator new(bytes));
+        end_ = next_ + bytes;
+        chunks_.push_back(next_);
+        reservedBytes_ += bytes;
+        nextChunkBytes_ = std::min(nextChunkBytes_ * 2, MAX_CHUNK_BYTES);
+    }
+
+    std::vector<char*> chunks_;
+    char* next_ = nullptr;
+    char* end_ = nullptr;
+    std::size_t nextChunkBytes_ = FIRST_CHUNK_BYTES;
+    std::size_t usedBytes_ = 0;
+    std::size_t reservedBytes_ = 0;
+};
+
+// Size-class free lists carved from an arena
+class Pool {
+public:
+    Pool() {
+        std::fill(freeLists_, freeLists_ + SIZE_CLASSES, nullptr);
+    }
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    void* allocate(std::size_t bytes) {
+        const std::size_t sizeClass = sizeClassOf(bytes);
+        liveBytes_ += (sizeClass + 1) * POOL_GRANULE;
+        FreeBlock* block = freeLists_[sizeClass];
+        if (block != nullptr) {
+            freeLists_[sizeClass] = block->next;
+            reused_++;
+            return block;
+        }
+        return arena_.allocate((sizeClass + 1) * POOL_GRANULE, POOL_GRANULE);
+    }
+
+    void deallocate(void* memory, std::size_t bytes) noexcept {
+        const std::size_t sizeClass = sizeClassOf(bytes);
+        liveBytes_ -= (sizeClass + 1) * POOL_GRANULE;
+        FreeBlock* block = static_cast<FreeBlock*>(memory);
+        block->next = freeLists_[sizeClass];
+        freeLists_[sizeClass] = block;
+    }
+
+    // Bytes in live blocks (rounded to their class), allocations served from a free list
+    std::size_t liveBytes() const { return liveBytes_; }
+    std::size_t reused() const { return reused_; }
+    const Arena& arena() const { return arena_; }
+
+    std::size_t largeBytes = 0;
+
+private:
+    static constexpr std::size_t SIZE_CLASSES = SMALL_ALLOCATION / POOL_GRANULE;
+
+    // A zero-byte request takes the smallest class, a block must hold a FreeBlock
+    static std::size_t sizeClassOf(std::size_t bytes) noexcept {
+        return bytes == 0 ? 0 : (bytes - 1) / POOL_GRANULE;
+    }
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    Arena arena_;
+    FreeBlock* freeLists_[SIZE_CLASSES];
+    std::size_t liveBytes_ = 0;
+    std::size_t reused_ = 0;
+};
+
+} // namespace node_allocator_detail
+
+template <typename T>
+class ArenaAllocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "ArenaAllocator does not support over-aligned types.");
+
+public:
+    typedef T value_type;
+    // Moving or swapping containers takes their nodes along with the arena
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator() : arena_(std::make_shared<node_allocator_detail::Arena>()) {}
+
+    // No move constructor: a moved-from container must still be able to allocate
+    ArenaAllocator(const ArenaAllocator& other) noexcept : arena_(other.arena_) {}
+    ArenaAllocator& operator=(const ArenaAllocator& other) noexcept = default;
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+    T* allocate(std::size_t n) {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes > node_allocator_detail::SMALL_ALLOCATION) {
+            return static_cast<T*>(node_allocator_detail::allocateLarge(bytes, arena_->largeBytes));
+        }
+        return static_cast<T*>(arena_->allocate(bytes, alignof(T)));
+    }
+
+    void deallocate(T* pointer, std::size_t n) noexcept {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes > node_allocator_detail::SMALL_ALLOCATION) {
+            node_allocator_detail::deallocateLarge(pointer, bytes, arena_->largeBytes);
+        }
+    }
+
+    const node_allocator_detail::Arena& arena() const noexcept {
+        return *arena_;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+        return arena_ != other.arena_;
+    }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    std::shared_ptr<node_allocator_detail::Arena> arena_;
+};
+
+template <typename T>
+class PoolAllocator {
+    static_assert(alignof(T) <= node_allocator_detail::POOL_GRANULE, "PoolAllocator does not support over-aligned types.");
+
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    PoolAllocator() : pool_(std::make_shared<node_allocator_detail::Pool>()) {}
+
+    // No move constructor: a moved-from container must still be able to allocate
+    PoolAllocator(const PoolAllocator& other) noexcept : pool_(other.pool_) {}
+    PoolAllocator& operator=(const PoolAllocator& other) noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : pool_(other.pool_) {}
+
+    T* allocate(std::size_t n) {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes > node_allocator_detail::SMALL_ALLOCATION) {
+            return static_cast<T*>(node_allocator_detail::allocateLarge(bytes, pool_->largeBytes));
+        }
+        return static_cast<T*>(pool_->allocate(bytes));
+    }
+
+    void deallocate(T* pointer, std::size_t n) noexcept {
+        const std::size_t bytes = n * sizeof(T);
+        if (bytes > node_allocator_detail::SMALL_ALLOCATION) {
+            node_allocator_detail::deallocateLarge(pointer, bytes, pool_->largeBytes);
+            return;
+        }
+        pool_->deallocate(pointer, bytes);
+    }
+
+    const node_allocator_detail::Pool& pool() const noexcept {
+        return *pool_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool_;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return pool_ != other.pool_;
+    }
+
+private:
+    template <typename U>
+    friend class PoolAllocator;
+
+    std::shared_ptr<node_allocator_detail::Pool> pool_;
+};
+
+#endif
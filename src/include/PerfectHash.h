@@ -0,0 +1,197 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace mphf_detail {
+
+// Finalizer of MurmurHash3, spreads any 64-bit input over all output bits
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Map a 64-bit hash to [0, range) without a division
+inline uint64_t reduce(uint64_t hash, uint64_t range) {
+    return uint64_t((static_cast<unsigned __int128>(hash) * range) >> 64);
+}
+
+} // namespace mphf_detail
+
+/*
+ * Minimal perfect hash function following the BBHash construction
+ * (Limasset et al., "Fast and scalable minimal perfect hashing for massive
+ * key sets").
+ *
+ * Level i is a bit array of gamma * (keys left) bits. Every remaining key is
+ * hashed to one bit with a per-level seed; keys alone on their bit keep it,
+ * colliding keys are retried on the next level. The index of a key is the
+ * rank of its bit over the concatenation of all levels, which gives a
+ * bijection from the key set onto [0, n). Keys still colliding after
+ * MAX_LEVELS levels are kept in a small fallback map.
+ *
+ * Keys outside the build set map to an arbitrary index (or to size() when no
+ * level claims them): membership has to be checked by the caller.
+ */
+template <typename Key, class Hash = std::hash<Key>>
+class BBHash {
+public:
+    explicit BBHash(double gamma = 2.0) : gamma_(gamma < 1.0 ? 1.0 : gamma), size_(0) {}
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    std::size_t levels() const {
+        return levelOffsets_.empty() ? 0 : levelOffsets_.size() - 1;
+    }
+
+    std::size_t fallbackSize() const {
+        return fallback_.size();
+    }
+
+    // Bytes used by the bit arrays, their rank samples and the fallback map
+    std::size_t memoryBytes() const {
+        return bits_.size() * sizeof(uint64_t) + blockRanks_.size() * sizeof(uint64_t) +
+               levelOffsets_.size() * sizeof(uint64_t) +
+               fallback_.size() * (sizeof(Key) + sizeof(std::size_t) + 2 * sizeof(void*));
+    }
+
+    // Build over a set of distinct keys
+    void build(const std::vector<Key>& keys) {
+        bits_.clear();
+        blockRanks_.clear();
+        levelOffsets_.clear();
+        fallback_.clear();
+        size_ = keys.size();
+
+        std::vector<uint64_t> remaining;
+        remaining.reserve(keys.size());
+        for (const Key& key : keys) {
+            remaining.push_back(uint64_t(hasher_(key)));
+        }
+
+        std::vector<uint64_t> collisions;
+        std::vector<uint64_t> next;
+        levelOffsets_.push_back(0);
+        for (std::size_t level = 0; level < MAX_LEVELS && !remaining.empty(); level++) {
+            const uint64_t levelBits = roundToWord(uint64_t(double(remaining.size()) * gamma_) + 1);
+            const uint64_t offset = levelOffsets_.back();
+            bits_.resize((offset + levelBits) / 64, 0);
+            collisions.assign(levelBits / 64, 0);
+
+            for (uint64_t hash : remaining) {
+                const uint64_t pos = mphf_detail::reduce(levelHash(hash, level), levelBits);
+                if (testBit(collisions, pos)) {
+                    continue;
+                }
+                if (testBit(bits_, offset + pos)) {
+                    setBit(collisions, pos);
+                } else {
+                    setBit(bits_, offset + pos);
+                }
+            }
+            // Colliding keys lose the bit and move to the next level
+            next.clear();
+            for (uint64_t hash : remaining) {
+                const uint64_t pos = mphf_detail::reduce(levelHash(hash, level), levelBits);
+                if (testBit(collisions, pos)) {
+                    next.push_back(hash);
+                }
+            }
+            for (std::size_t word = 0; word < collisions.size(); word++) {
+                bits_[offset / 64 + word] &= ~collisions[word];
+            }
+            remaining.swap(next);
+            levelOffsets_.push_back(offset + levelBits);
+        }
+
+        blockRanks_.reserve(bits_.size() / WORDS_PER_BLOCK + 1);
+        uint64_t rank = 0;
+        for (std::size_t word = 0; word < bits_.size(); word++) {
+            if (word % WORDS_PER_BLOCK == 0) {
+                blockRanks_.push_back(rank);
+            }
+            rank += uint64_t(__builtin_popcountll(bits_[word]));
+        }
+
+        if (!remaining.empty()) {
+            // Rare: identify the leftover keys by hash and append them after the ranked ones
+            for (const Key& key : keys) {
+                const uint64_t hash = uint64_t(hasher_(key));
+                if (lookupInLevels(hash) == size_) {
+                    fallback_.emplace(key, std::size_t(rank + fallback_.size()));
+                }
+            }
+        }
+    }
+
+    // Index in [0, size()) of a key of the build set
+    std::size_t lookup(const Key& key) const {
+        const std::size_t index = lookupInLevels(uint64_t(hasher_(key)));
+        if (index != size_ || fallback_.empty()) {
+            return index;
+        }
+        auto it = fallback_.find(key);
+        return it == fallback_.end() ? size_ : it->second;
+    }
+
+private:
+    static const std::size_t MAX_LEVELS = 32;
+    static const std::size_t WORDS_PER_BLOCK = 8;
+
+    static uint64_t roundToWord(uint64_t bits) {
+        return (bits + 63) / 64 * 64;
+    }
+
+    static uint64_t levelHash(uint64_t hash, std::size_t level) {
+        return mphf_detail::mix64(hash + 0x9e3779b97f4a7c15ULL * (level + 1));
+    }
+
+    static bool testBit(const std::vector<uint64_t>& bits, uint64_t pos) {
+        return (bits[pos / 64] >> (pos % 64)) & 1;
+    }
+
+    static void setBit(std::vector<uint64_t>& bits, uint64_t pos) {
+        bits[pos / 64] |= uint64_t(1) << (pos % 64);
+    }
+
+    uint64_t rank(uint64_t pos) const {
+        const uint64_t word = pos / 64;
+        uint64_t result = blockRanks_[word / WORDS_PER_BLOCK];
+        for (uint64_t i = word - word % WORDS_PER_BLOCK; i < word; i++) {
+            result += uint64_t(__builtin_popcountll(bits_[i]));
+        }
+        const uint64_t mask = (uint64_t(1) << (pos % 64)) - 1;
+        return result + uint64_t(__builtin_popcountll(bits_[word] & mask));
+    }
+
+    std::size_t lookupInLevels(uint64_t hash) const {
+        for (std::size_t level = 0; level + 1 < levelOffsets_.size(); level++) {
+            const uint64_t levelBits = levelOffsets_[level + 1] - levelOffsets_[level];
+            const uint64_t pos = levelOffsets_[level] + mphf_detail::reduce(levelHash(hash, level), levelBits);
+            if (testBit(bits_, pos)) {
+                return std::size_t(rank(pos));
+            }
+        }
+        return size_;
+    }
+
+    Hash hasher_;
+    double gamma_;
+    std::size_t size_;
+    std::vector<uint64_t> bits_;
+    std::vector<uint64_t> blockRanks_;
+    std::vector<uint64_t> levelOffsets_;
+    std::unordered_map<Key, std::size_t, Hash> fallback_;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef RCU_MAP_H
+#define RCU_MAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "tsl/hopscotch_map.h"
+
+namespace rcu_detail {
+
+static const std::size_t MAX_THREADS = 256;
+
+// Process-wide reader slots, a thread keeps its slot until it exits
+inline std::atomic<bool>* slotsInUse() {
+    static std::atomic<bool> inUse[MAX_THREADS];
+    return inUse;
+}
+
+struct ThreadSlot {
+    std::size_t index;
+
+    ThreadSlot() {
+        for (index = 0; index < MAX_THREADS; index++) {
+            bool expected = false;
+            if (slotsInUse()[index].compare_exchange_strong(expected, true)) {
+                return;
+            }
+        }
+        throw std::runtime_error("RcuMap supports at most rcu_detail::MAX_THREADS concurrent threads.");
+    }
+
+    ~ThreadSlot() {
+        slotsInUse()[index].store(false);
+    }
+};
+
+inline std::size_t threadSlot() {
+    thread_local ThreadSlot slot;
+    return slot.index;
+}
+
+} // namespace rcu_detail
+
+/*
+ * Read-mostly map with RCU-style publication and epoch-based reclamation.
+ *
+ * Readers see an immutable tsl::hopscotch_map snapshot through an atomic
+ * pointer. A lookup announces the current global epoch in the reader's own
+ * cache-line-sized slot, loads the pointer, probes the snapshot and clears
+ * the slot: no lock and no shared cache line is written, so readers never
+ * wait and never contend with each other or with writers.
+ *
+ * Writers queue updates with insert(); publish() copies the current
+ * snapshot, applies the queued updates to the copy, swaps the pointer and
+ * advances the epoch. The replaced snapshot is freed once no reader slot
+ * holds an epoch older than the one it was retired at. Writers serialize on
+ * a mutex and pay a full copy per publish, so updates should be batched.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class RcuMap {
+public:
+    typedef tsl::hopscotch_map<Key, Value, Hash> Snapshot;
+
+    RcuMap() : snapshot_(new Snapshot()), epoch_(1), publishes_(0), readerEpochs_(new ReaderEpoch[rcu_detail::MAX_THREADS]) {
+        for (std::size_t i = 0; i < rcu_detail::MAX_THREADS; i++) {
+            readerEpochs_[i].epoch.store(QUIESCENT, std::memory_order_relaxed);
+        }
+    }
+
+    RcuMap(const RcuMap&) = delete;
+    RcuMap& operator=(const RcuMap&) = delete;
+
+    ~RcuMap() {
+        delete snapshot_.load();
+        for (auto& retired : retired_) {
+            delete retired.first;
+        }
+    }
+
+    // Size of the published snapshot
+    std::size_t size() const {
+        ReadGuard guard(*this);
+        return guard.snapshot().size();
+    }
+
+    std::size_t publishes() const {
+        return publishes_.load(std::memory_order_relaxed);
+    }
+
+    // Replaced snapshots still waiting for readers to move past them
+    std::size_t retiredSnapshots() const {
+        std::lock_guard<std::mutex> lock(writerLock_);
+        return retired_.size();
+    }
+
+    bool find(const Key& key, Value& value) const {
+        ReadGuard guard(*this);
+        auto it = guard.snapshot().find(key);
+        if (it == guard.snapshot().end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    // Queue an update, readers see it after the next publish().
+    void insert(const Key& key, const Value& value) {
+        std::lock_guard<std::mutex> lock(writerLock_);
+        pending_.emplace_back(key, value);
+    }
+
+    // Apply the queued updates to a copy of the snapshot and make it current.
+    void publish() {
+        std::lock_guard<std::mutex> lock(writerLock_);
+        if (pending_.empty()) {
+            return;
+        }
+        std::unique_ptr<Snapshot> next(new Snapshot(*snapshot_.load(std::memory_order_relaxed)));
+        for (const auto& update : pending_) {
+            (*next)[update.first] = update.second;
+        }
+        pending_.clear();
+
+        const Snapshot* previous = snapshot_.exchange(next.release());
+        // Readers announcing the new epoch loaded the pointer after the exchange
+        const uint64_t retireEpoch = epoch_.fetch_add(1) + 1;
+        retired_.emplace_back(previous, retireEpoch);
+        publishes_.fetch_add(1, std::memory_order_relaxed);
+        reclaim();
+    }
+
+private:
+    static const uint64_t QUIESCENT = 0;
+
+    struct ReaderEpoch {
+        std::atomic<uint64_t> epoch;
+        // Keep every reader on its own cache line
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Announces the reader's epoch for the lifetime of a lookup
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const RcuMap& map) : slot_(map.readerEpochs_[rcu_detail::threadSlot()].epoch) {
+            slot_.store(map.epoch_.load());
+            snapshot_ = map.snapshot_.load();
+        }
+
+        ~ReadGuard() {
+            slot_.store(QUIESCENT, std::memory_order_release);
+        }
+
+        const Snapshot& snapshot() const {
+            return *snapshot_;
+        }
+
+    private:
+        std::atomic<uint64_t>& slot_;
+        const Snapshot* snapshot_;
+    };
+
+    // Free retired snapshots older than every active reader. Caller holds writerLock_.
+    void reclaim() {
+        uint64_t oldestReader = UINT64_MAX;
+        for (std::size_t i = 0; i < rcu_detail::MAX_THREADS; i++) {
+            const uint64_t epoch = readerEpochs_[i].epoch.load();
+            if (epoch != QUIESCENT && epoch < oldestReader) {
+                oldestReader = epoch;
+            }
+        }
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < retired_.size(); i++) {
+            if (retired_[i].second <= oldestReader) {
+                delete retired_[i].first;
+            } else {
+                retired_[kept++] = retired_[i];
+            }
+        }
+        retired_.resize(kept);
+    }
+
+    std::atomic<const Snapshot*> snapshot_;
+    std::atomic<uint64_t> epoch_;
+    std::atomic<std::size_t> publishes_;
+    std::unique_ptr<ReaderEpoch[]> readerEpochs_;
+
+    mutable std::mutex writerLock_;
+    std::vector<std::pair<Key, Value>> pending_;
+    // Replaced snapshots with the epoch they were retired at
+    std::vector<std::pair<const Snapshot*, uint64_t>> retired_;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef ROW_HASH_TABLE_H
+#define ROW_HASH_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Hash table laid out like HashMem's in-memory buckets: the table is an array
+ * of DRAM-row-sized buckets (rowBytes, e.g. 1-8 KB) allocated on a page
+ * boundary. A row holds its fill count followed by the packed keys and then
+ * the packed values:
+ *
+ *   | count | pad | key[0] ... key[capacity-1] | value[0] ... value[capacity-1] |
+ *
+ * A key hashes to exactly one row, which is scanned (linearly or with SIMD
+ * for 32-bit keys) as a near-memory unit would scan an open row. When a row
+ * is full the number of rows doubles and every key is redistributed.
+ */
+namespace rowhash_detail {
+
+static const std::size_t ROW_HEADER_BYTES = 64;
+static const std::size_t PAGE_BYTES = 4096;
+
+// Index of key in keys[0, count), count if absent.
+template <typename Key>
+inline std::size_t scanRow(const Key* keys, std::size_t count, const Key& key, bool /*simd*/) {
+    for (std::size_t i = 0; i < count; i++) {
+        if (keys[i] == key) {
+            return i;
+        }
+    }
+    return count;
+}
+
+#if defined(__SSE2__)
+inline std::size_t scanRow(const int32_t* keys, std::size_t count, const int32_t& key, bool simd) {
+    std::size_t i = 0;
+    if (simd) {
+#if defined(__AVX2__)
+        const __m256i needle8 = _mm256_set1_epi32(key);
+        for (; i + 8 <= count; i += 8) {
+            const __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i*>(keys + i));
+            const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle8)));
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+        const __m128i needle = _mm_set1_epi32(key);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + i));
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+    }
+    for (; i < count; i++) {
+        if (keys[i] == key) {
+            return i;
+        }
+    }
+    return count;
+}
+#endif
+
+} // namespace rowhash_detail
+
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class RowHashTable {
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "RowHashTable packs keys and values in raw rows.");
+
+public:
+    struct Stats {
+        std::size_t rows;
+        std::size_t rowBytes;
+        std::size_t rowCapacity;
+        double averageFill;
+        std::size_t maxFill;
+        std::size_t memoryBytes;
+    };
+
+    explicit RowHashTable(std::size_t rowBytes = 2048, bool simdScan = true, const Hash& hash = Hash())
+        : hash_(hash), rowBytes_(rowBytes), simdScan_(simdScan), rowCapacity_(0), rowShift_(0), rows_(0),
+          size_(0), data_(nullptr) {
+        if (rowBytes_ % 64 != 0 || rowBytes_ < 256) {
+            throw std::invalid_argument("RowHashTable row size must be a multiple of 64 bytes and >= 256.");
+        }
+        // Keep the key array a multiple of a cache line so the values start on a line boundary
+        rowCapacity_ = (rowBytes_ - rowhash_detail::ROW_HEADER_BYTES) / (sizeof(Key) + sizeof(Value));
+        rowCapacity_ -= rowCapacity_ % (64 / sizeof(Key) ? 64 / sizeof(Key) : 1);
+        allocateRows(1);
+    }
+
+    RowHashTable(const RowHashTable&) = delete;
+    RowHashTable& operator=(const RowHashTable&) = delete;
+
+    ~RowHashTable() {
+        free(data_);
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    const Value* find(const Key& key) const {
+        const unsigned char* row = rowFor(key);
+        const std::size_t count = rowCount(row);
+        const std::size_t index = rowhash_detail::scanRow(rowKeys(row), count, key, simdScan_);
+        return index < count ? rowValues(row) + index : nullptr;
+    }
+
+    void insert(const Key& key, const Value& value) {
+        for (;;) {
+            unsigned char* row = rowFor(key);
+            const std::size_t count = rowCount(row);
+            const std::size_t index = rowhash_detail::scanRow(rowKeys(row), count, key, simdScan_);
+            if (index < count) {
+                rowValues(row)[index] = value;
+                return;
+            }
+            if (count < rowCapacity_) {
+                rowKeys(row)[count] = key;
+                rowValues(row)[count] = value;
+                setRowCount(row, count + 1);
+                size_++;
+                return;
+            }
+            grow();
+        }
+    }
+
+    Stats stats() const {
+        Stats result;
+        result.rows = rows_;
+        result.rowBytes = rowBytes_;
+        result.rowCapacity = rowCapacity_;
+        result.maxFill = 0;
+        for (std::size_t i = 0; i < rows_; i++) {
+            result.maxFill = std::max(result.maxFill, rowCount(data_ + i * rowBytes_));
+        }
+        result.averageFill = rows_ ? double(size_) / double(rows_) : 0;
+        result.memoryBytes = rows_ * rowBytes_;
+        return result;
+    }
+
+private:
+    std::size_t rowIndex(const Key& key) const {
+        // Fibonacci hashing: std::hash is the identity for integers, take the
+        // top bits of a multiplicative mix so consecutive keys spread over rows
+        const uint64_t mixed = uint64_t(hash_(key)) * 0x9e3779b97f4a7c15ULL;
+        return rowShift_ >= 64 ? 0 : std::size_t(mixed >> rowShift_);
+    }
+
+    unsigned char* rowFor(const Key& key) {
+        return data_ + rowIndex(key) * rowBytes_;
+    }
+
+    const unsigned char* rowFor(const Key& key) const {
+        return data_ + rowIndex(key) * rowBytes_;
+    }
+
+    static std::size_t rowCount(const unsigned char* row) {
+        return *reinterpret_cast<const uint32_t*>(row);
+    }
+
+    static void setRowCount(unsigned char* row, std::size_t count) {
+        *reinterpret_cast<uint32_t*>(row) = uint32_t(count);
+    }
+
+    static Key* rowKeys(unsigned char* row) {
+        return reinterpret_cast<Key*>(row + rowhash_detail::ROW_HEADER_BYTES);
+    }
+
+    static const Key* rowKeys(const unsigned char* row) {
+        return reinterpret_cast<const Key*>(row + rowhash_detail::ROW_HEADER_BYTES);
+    }
+
+    Value* rowValues(unsigned char* row) const {
+        return reinterpret_cast<Value*>(row + rowhash_detail::ROW_HEADER_BYTES + rowCapacity_ * sizeof(Key));
+    }
+
+    const Value* rowValues(const unsigned char* row) const {
+        return reinterpret_cast<const Value*>(row + rowhash_detail::ROW_HEADER_BYTES + rowCapacity_ * sizeof(Key));
+    }
+
+    void allocateRows(std::size_t rows) {
+        void* data = nullptr;
+        if (posix_memalign(&data, rowhash_detail::PAGE_BYTES, rows * rowBytes_) != 0) {
+            throw std::bad_alloc();
+        }
+        data_ = static_cast<unsigned char*>(data);
+        rows_ = rows;
+        rowShift_ = 64;
+        for (std::size_t r = rows; r > 1; r >>= 1) {
+            rowShift_--;
+        }
+        for (std::size_t i = 0; i < rows_; i++) {
+            setRowCount(data_ + i * rowBytes_, 0);
+        }
+    }
+
+    // Double the number of rows and redistribute every key
+    void grow() {
+        unsigned char* oldData = data_;
+        const std::size_t oldRows = rows_;
+        allocateRows(oldRows * 2);
+        size_ = 0;
+        for (std::size_t r = 0; r < oldRows; r++) {
+            unsigned char* row = oldData + r * rowBytes_;
+            const Key* keys = rowKeys(row);
+            const Value* values = rowValues(row);
+            for (std::size_t i = 0; i < rowCount(row); i++) {
+                insert(keys[i], values[i]);
+            }
+        }
+        free(oldData);
+    }
+
+    Hash hash_;
+    std::size_t rowBytes_;
+    bool simdScan_;
+    std::size_t rowCapacity_;
+    unsigned rowShift_;
+    std::size_t rows_;
+    std::size_t size_;
+    unsigned char* data_;
+};
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef SHARDED_MAP_H
+#define SHARDED_MAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "tsl/hopscotch_map.h"
+
+namespace sharded_detail {
+
+/*
+ * Bounded single-producer/single-consumer ring. The consumer only releases a
+ * slot (popFront) after it is done with the element, so an empty ring also
+ * means every pushed element was fully processed.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) : head_(0), tail_(0) {
+        std::size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        slots_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    bool push(const T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Oldest element or nullptr if the ring is empty
+    const T* front() const {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    void popFront() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_;
+    // Producer and consumer indexes on separate cache lines
+    alignas(64) std::atomic<std::size_t> head_;
+    alignas(64) std::atomic<std::size_t> tail_;
+};
+
+} // namespace sharded_detail
+
+/*
+ * Shared-nothing hash map: the key space is split over shards by the top bits
+ * of a mixed hash, and every shard is a private tsl::hopscotch_map owned by
+ * one worker thread (pinned to a core on Linux). Other threads never touch a
+ * shard's memory; they are clients sending requests through one
+ * single-producer/single-consumer ring per (client, shard) pair, and lookups
+ * are answered through rings in the opposite direction.
+ *
+ * A client routes a whole batch of keys before collecting the answers, so
+ * each shard drains many requests per pass over its rings and the round
+ * trip cost is amortized over the batch.
+ *
+ * Operations of one client reach a shard in order. Inserts are not
+ * acknowledged: flush() waits until the shards processed every request of
+ * the client, after which the inserts are visible to all clients.
+ *
+ * A client id must only be used by one thread at a time.
+ */
+template <typename Key, typename Value, class Hash = std::hash<Key>>
+class ShardedMap {
+public:
+    static const std::size_t SHARD_BATCH = 64;
+
+    ShardedMap(std::size_t shards, std::size_t clients, std::size_t ringCapacity = 1024, bool pinShards = true,
+               const Hash& hash = Hash())
+        : hash_(hash), shardCount_(shards ? shards : 1), clientCount_(clients ? clients : 1), stop_(false) {
+        for (std::size_t i = 0; i < shardCount_ * clientCount_; i++) {
+            requests_.emplace_back(new sharded_detail::SpscRing<Request>(ringCapacity));
+            responses_.emplace_back(new sharded_detail::SpscRing<Response>(ringCapacity));
+        }
+        for (std::size_t s = 0; s < shardCount_; s++) {
+            shards_.emplace_back(new Shard());
+        }
+        for (std::size_t s = 0; s < shardCount_; s++) {
+            shards_[s]->worker = std::thread(&ShardedMap::runShard, this, s);
+            if (pinShards) {
+                pin(shards_[s]->worker, s);
+            }
+        }
+    }
+
+    ShardedMap(const ShardedMap&) = delete;
+    ShardedMap& operator=(const ShardedMap&) = delete;
+
+    ~ShardedMap() {
+        stop_.store(true, std::memory_order_release);
+        for (auto& shard : shards_) {
+            shard->worker.join();
+        }
+    }
+
+    std::size_t shards() const {
+        return shardCount_;
+    }
+
+    std::size_t clients() const {
+        return clientCount_;
+    }
+
+    std::size_t shardSize(std::size_t shard) const {
+        return shards_[shard]->size.load(std::memory_order_relaxed);
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (std::size_t s = 0; s < shardCount_; s++) {
+            total += shardSize(s);
+        }
+        return total;
+    }
+
+    void insertBatch(std::size_t client, const Key* keys, const Value* values, std::size_t n) {
+        for (std::size_t i = 0; i < n; i++) {
+            Request request;
+            request.op = INSERT;
+            request.key = keys[i];
+            request.value = values[i];
+            request.tag = 0;
+            sharded_detail::SpscRing<Request>& ring = requestRing(shardFor(keys[i]), client);
+            while (!ring.push(request)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Wait until the shards processed every request sent by client.
+    void flush(std::size_t client) {
+        for (std::size_t s = 0; s < shardCount_; s++) {
+            while (!requestRing(s, client).empty()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Look up n keys; found[i] tells whether values[i] was set.
+    void findBatch(std::size_t client, const Key* keys, std::size_t n, Value* values, bool* found) {
+        std::size_t outstanding = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            Request request;
+            request.op = FIND;
+            request.key = keys[i];
+            request.tag = uint32_t(i);
+            sharded_detail::SpscRing<Request>& ring = requestRing(shardFor(keys[i]), client);
+            while (!ring.push(request)) {
+                // Shards may be blocked on our full response rings
+                if (collect(client, values, found, outstanding) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            outstanding++;
+        }
+        while (outstanding > 0) {
+            if (collect(client, values, found, outstanding) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    enum Operation : uint8_t { FIND, INSERT };
+
+    struct Request {
+        Key key;
+        Value value;
+        uint32_t tag;
+        Operation op;
+    };
+
+    struct Response {
+        Value value;
+        uint32_t tag;
+        bool found;
+    };
+
+    struct Shard {
+        std::thread worker;
+        std::atomic<std::size_t> size{0};
+    };
+
+    static void pin(std::thread& thread, std::size_t shard) {
+#if defined(__linux__)
+        const unsigned cores = std::thread::hardware_concurrency();
+        if (cores == 0) {
+            return;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(shard % cores, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)shard;
+#endif
+    }
+
+    // Top bits of a mixed hash select the shard
+    std::size_t shardFor(const Key& key) const {
+        const uint64_t mixed = uint64_t(hash_(key)) * 0x9e3779b97f4a7c15ULL;
+        return std::size_t((static_cast<unsigned __int128>(mixed) * shardCount_) >> 64);
+    }
+
+    sharded_detail::SpscRing<Request>& requestRing(std::size_t shard, std::size_t client) {
+        return *requests_[shard * clientCount_ + client];
+    }
+
+    sharded_detail::SpscRing<Response>& responseRing(std::size_t shard, std::size_t client) {
+        return *responses_[shard * clientCount_ + client];
+    }
+
+    std::size_t collect(std::size_t client, Value* values, bool* found, std::size_t& outstanding) {
+        std::size_t received = 0;
+        for (std::size_t s = 0; s < shardCount_; s++) {
+            sharded_detail::SpscRing<Response>& ring = responseRing(s, client);
+            while (const Response* response = ring.front()) {
+                found[response->tag] = response->found;
+                if (response->found) {
+                    values[response->tag] = response->value;
+                }
+                ring.popFront();
+                received++;
+            }
+        }
+        outstanding -= received;
+        return received;
+    }
+
+    void runShard(std::size_t shard) {
+        tsl::hopscotch_map<Key, Value, Hash> partition;
+        Shard& state = *shards_[shard];
+        while (!stop_.load(std::memory_order_acquire)) {
+            bool idle = true;
+            for (std::size_t client = 0; client < clientCount_; client++) {
+                sharded_detail::SpscRing<Request>& ring = requestRing(shard, client);
+                for (std::size_t n = 0; n < SHARD_BATCH; n++) {
+                    const Request* request = ring.front();
+                    if (request == nullptr) {
+                        break;
+                    }
+                    idle = false;
+                    if (request->op == INSERT) {
+                        partition[request->key] = request->value;
+                        state.size.store(partition.size(), std::memory_order_relaxed);
+                    } else {
+                        Response response;
+                        response.tag = request->tag;
+                        auto it = partition.find(request->key);
+                        response.found = it != partition.end();
+                        response.value = response.found ? it->second : Value();
+                        while (!responseRing(shard, client).push(response)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    ring.popFront();
+                }
+            }
+            if (idle) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    Hash hash_;
+    std::size_t shardCount_;
+    std::size_t clientCount_;
+    std::atomic<bool> stop_;
+    std::vector<std::unique_ptr<sharded_detail::SpscRing<Request>>> requests_;
+    std::vector<std::unique_ptr<sharded_detail::SpscRing<Response>>> responses_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif
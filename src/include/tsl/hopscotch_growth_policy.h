@@ -231,6 +231,87 @@ class mod_growth_policy {
   std::size_t m_mod;
 };
 
+/**
+ * Grow the hash table by GrowthFactor::num / GrowthFactor::den and map a hash
+ * to a bucket with Lemire's multiply-high reduction, (hash * bucket_count) >>
+ * 64: a multiplication instead of the division of mod_growth_policy, for any
+ * bucket count. A factor like 5/4 keeps the table at most 25% larger than
+ * needed right after a grow, where doubling wastes up to half of it.
+ *
+ * The bucket is taken from the high bits of the hash, the hash function must
+ * spread the keys over all the bits of std::size_t (std::hash on integers,
+ * the identity in libstdc++, puts all small keys in the first bucket).
+ */
+template <class GrowthFactor = std::ratio<5, 4>>
+class fastrange_growth_policy {
+ public:
+  explicit fastrange_growth_policy(std::size_t& min_bucket_count_in_out) {
+    if (min_bucket_count_in_out > max_bucket_count()) {
+      TSL_HH_THROW_OR_TERMINATE(std::length_error,
+                                "The hash table exceeds its maximum size.");
+    }
+
+    m_bucket_count = min_bucket_count_in_out;
+  }
+
+  std::size_t bucket_for_hash(std::size_t hash) const noexcept {
+    return multiply_high(hash, m_bucket_count);
+  }
+
+  std::size_t next_bucket_count() const {
+    if (m_bucket_count == max_bucket_count()) {
+      TSL_HH_THROW_OR_TERMINATE(std::length_error,
+                                "The hash table exceeds its maximum size.");
+    }
+
+    // Grow by at least one bucket, small counts times 5/4 round down to
+    // themselves
+    const std::size_t growth = std::max<std::size_t>(
+        1, m_bucket_count / GrowthFactor::den *
+                   (GrowthFactor::num - GrowthFactor::den) +
+               m_bucket_count % GrowthFactor::den *
+                   (GrowthFactor::num - GrowthFactor::den) /
+                   GrowthFactor::den);
+    if (growth > max_bucket_count() - m_bucket_count) {
+      return max_bucket_count();
+    }
+
+    return m_bucket_count + growth;
+  }
+
+  std::size_t max_bucket_count() const {
+    return std::numeric_limits<std::size_t>::max() / 2;
+  }
+
+  void clear() noexcept { m_bucket_count = 0; }
+
+ private:
+  static std::size_t multiply_high(std::size_t hash,
+                                   std::size_t bucket_count) noexcept {
+#if SIZE_MAX > UINT32_MAX && defined(__SIZEOF_INT128__)
+    return std::size_t((unsigned __int128)hash * bucket_count >> 64);
+#elif SIZE_MAX > UINT32_MAX
+    const std::uint64_t hash_low = hash & 0xffffffffu, hash_high = hash >> 32;
+    const std::uint64_t count_low = bucket_count & 0xffffffffu,
+                        count_high = bucket_count >> 32;
+    const std::uint64_t low_high = hash_low * count_high;
+    const std::uint64_t high_low = hash_high * count_low;
+    const std::uint64_t middle = ((hash_low * count_low) >> 32) +
+                                 (low_high & 0xffffffffu) +
+                                 (high_low & 0xffffffffu);
+    return std::size_t(hash_high * count_high + (low_high >> 32) +
+                       (high_low >> 32) + (middle >> 32));
+#else
+    return std::size_t(std::uint64_t(hash) * bucket_count >> 32);
+#endif
+  }
+
+  static_assert(GrowthFactor::num > GrowthFactor::den,
+                "Growth factor should be > 1.");
+
+  std::size_t m_bucket_count;
+};
+
 namespace detail {
 
 #if SIZE_MAX >= ULLONG_MAX
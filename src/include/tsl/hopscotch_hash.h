@@ -29,6 +29,7 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <functional>
 #include <initializer_list>
@@ -37,6 +38,7 @@
 #include <memory>
 #include <new>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -44,11 +46,69 @@
 
 #include "hopscotch_growth_policy.h"
 
+#if defined(__AVX2__) && defined(__GNUC__) && !defined(TSL_HH_NO_AVX2_FINGERPRINTS)
+#define TSL_HH_AVX2_FINGERPRINTS
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TSL_HH_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define TSL_HH_PREFETCH(address) ((void)(address))
+#endif
+
 #if (defined(__GNUC__) && (__GNUC__ == 4) && (__GNUC_MINOR__ < 9))
 #define TSL_HH_NO_RANGE_ERASE_WITH_CONST_ITERATOR
 #endif
 
 namespace tsl {
+namespace hh {
+
+/**
+ * Occupancy of a hopscotch table and counters of its insertions, see
+ * hopscotch_hash::statistics().
+ */
+struct hopscotch_statistics {
+  std::size_t size;
+  std::size_t bucket_count;
+  float load_factor;
+  std::size_t overflow_size;
+  /**
+   * distance_histogram[d] elements are d buckets after their home bucket,
+   * one entry per position of the neighborhood.
+   */
+  std::vector<std::size_t> distance_histogram;
+  /**
+   * Mean, over the buckets home to at least one element, of the fraction of
+   * the NeighborhoodSize buckets starting there that hold an element. Close
+   * to 1 the inserts there need displacements or overflow.
+   */
+  double average_neighborhood_occupancy;
+
+  /**
+   * Elements inserted in a bucket and in the overflow container. These and
+   * the counters below run from the construction of the table, the elements
+   * moved by a rehash are not counted again.
+   */
+  std::size_t bucket_inserts;
+  std::size_t overflow_inserts;
+  /**
+   * Elements moved by swap_empty_bucket_closer to bring an empty bucket into
+   * a neighborhood, in total and at most for one insert.
+   */
+  std::size_t displacements;
+  std::size_t max_displacements;
+  /**
+   * Rehashes because the load factor reached max_load_factor(), and because
+   * a neighborhood was full and will_neighborhood_change_on_rehash said a
+   * rehash would spread it.
+   */
+  std::size_t load_rehashes;
+  std::size_t neighborhood_rehashes;
+};
+
+}  // end namespace hh
+
 namespace detail_hopscotch_hash {
 
 template <typename T>
@@ -71,6 +131,14 @@ template <typename T>
 struct has_key_compare<T, typename make_void<typename T::key_compare>::type>
     : std::true_type {};
 
+template <typename T, typename = void>
+struct is_hashed_overflow : std::false_type {};
+
+template <typename T>
+struct is_hashed_overflow<
+    T, typename make_void<typename T::hashed_overflow_tag>::type>
+    : std::true_type {};
+
 template <typename U>
 struct is_power_of_two_policy : std::false_type {};
 
@@ -184,6 +252,10 @@ class hopscotch_bucket_hash<true> {
 
   truncated_hash_type truncated_bucket_hash() const noexcept { return m_hash; }
 
+  const truncated_hash_type* truncated_bucket_hash_address() const noexcept {
+    return std::addressof(m_hash);
+  }
+
  protected:
   void copy_hash(const hopscotch_bucket_hash& bucket) noexcept {
     m_hash = bucket.m_hash;
@@ -297,6 +369,12 @@ class hopscotch_bucket : public hopscotch_bucket_hash<StoreHash> {
         (1ull << (ineighbor + NB_RESERVED_BITS_IN_NEIGHBORHOOD)));
   }
 
+  void clear_neighborhood() noexcept {
+    m_neighborhood_infos = neighborhood_bitmap(
+        m_neighborhood_infos &
+        ((1ull << NB_RESERVED_BITS_IN_NEIGHBORHOOD) - 1));
+  }
+
   bool check_neighbor_presence(std::size_t ineighbor) const noexcept {
     tsl_hh_assert(ineighbor <= NeighborhoodSize);
     if (((m_neighborhood_infos >>
@@ -394,6 +472,154 @@ class hopscotch_bucket : public hopscotch_bucket_hash<StoreHash> {
   storage m_value;
 };
 
+/**
+ * Bucket for value types that are trivially copy constructible and trivially
+ * destructible (a std::pair of scalars is, though its assignment is not),
+ * selected with the CompactBuckets parameter of hopscotch_map and
+ * hopscotch_set. It behaves as hopscotch_bucket with two differences:
+ * - The neighborhood bitmap is kept as raw bytes after the value and read with
+ *   memcpy, so the bucket is only aligned as the value. A 16-bit bitmap next
+ *   to a std::pair<short, short> takes a 6-byte bucket instead of 8, with a
+ *   small NeighborhoodSize a std::pair<int, int> takes 10 bytes rounded to 12
+ *   instead of 16 for the 62-bucket default.
+ * - The bucket is trivially copyable and destructible: copying the table is a
+ *   memcpy of the bucket array, a displacement is a memcpy of the element and
+ *   clearing or freeing the buckets runs no destructor.
+ */
+template <typename ValueType, unsigned int NeighborhoodSize, bool StoreHash>
+class hopscotch_compact_bucket : public hopscotch_bucket_hash<StoreHash> {
+  static_assert(std::is_trivially_copy_constructible<ValueType>::value &&
+                    std::is_trivially_destructible<ValueType>::value,
+                "Compact buckets need a trivially copy constructible and "
+                "trivially destructible value_type.");
+  static_assert(NeighborhoodSize >= 4, "NeighborhoodSize should be >= 4.");
+  static_assert(NeighborhoodSize <= 62, "NeighborhoodSize should be <= 62.");
+  static_assert(!StoreHash || NeighborhoodSize <= 30,
+                "NeighborhoodSize should be <= 30 if StoreHash is true.");
+
+  using bucket_hash = hopscotch_bucket_hash<StoreHash>;
+
+ public:
+  using value_type = ValueType;
+  using neighborhood_bitmap = typename smallest_type_for_min_bits<
+      NeighborhoodSize + NB_RESERVED_BITS_IN_NEIGHBORHOOD>::type;
+
+  hopscotch_compact_bucket() noexcept : bucket_hash() {
+    store_infos(0);
+    tsl_hh_assert(empty());
+  }
+
+  neighborhood_bitmap neighborhood_infos() const noexcept {
+    return neighborhood_bitmap(load_infos() >>
+                               NB_RESERVED_BITS_IN_NEIGHBORHOOD);
+  }
+
+  void set_overflow(bool has_overflow) noexcept {
+    if (has_overflow) {
+      store_infos(neighborhood_bitmap(load_infos() | 2));
+    } else {
+      store_infos(neighborhood_bitmap(load_infos() & ~2));
+    }
+  }
+
+  bool has_overflow() const noexcept { return (load_infos() & 2) != 0; }
+
+  bool empty() const noexcept { return (load_infos() & 1) == 0; }
+
+  void toggle_neighbor_presence(std::size_t ineighbor) noexcept {
+    tsl_hh_assert(ineighbor <= NeighborhoodSize);
+    store_infos(neighborhood_bitmap(
+        load_infos() ^
+        (1ull << (ineighbor + NB_RESERVED_BITS_IN_NEIGHBORHOOD))));
+  }
+
+  void clear_neighborhood() noexcept {
+    store_infos(neighborhood_bitmap(
+        load_infos() & ((1ull << NB_RESERVED_BITS_IN_NEIGHBORHOOD) - 1)));
+  }
+
+  bool check_neighbor_presence(std::size_t ineighbor) const noexcept {
+    tsl_hh_assert(ineighbor <= NeighborhoodSize);
+    return ((load_infos() >> (ineighbor + NB_RESERVED_BITS_IN_NEIGHBORHOOD)) &
+            1) == 1;
+  }
+
+  value_type& value() noexcept {
+    tsl_hh_assert(!empty());
+#if defined(__cplusplus) && __cplusplus >= 201703L
+    return *std::launder(
+        reinterpret_cast<value_type*>(std::addressof(m_value)));
+#else
+    return *reinterpret_cast<value_type*>(std::addressof(m_value));
+#endif
+  }
+
+  const value_type& value() const noexcept {
+    tsl_hh_assert(!empty());
+#if defined(__cplusplus) && __cplusplus >= 201703L
+    return *std::launder(
+        reinterpret_cast<const value_type*>(std::addressof(m_value)));
+#else
+    return *reinterpret_cast<const value_type*>(std::addressof(m_value));
+#endif
+  }
+
+  template <typename... Args>
+  void set_value_of_empty_bucket(truncated_hash_type hash,
+                                 Args&&... value_type_args) {
+    tsl_hh_assert(empty());
+
+    ::new (static_cast<void*>(std::addressof(m_value)))
+        value_type(std::forward<Args>(value_type_args)...);
+    set_empty(false);
+    this->set_hash(hash);
+  }
+
+  void swap_value_into_empty_bucket(hopscotch_compact_bucket& empty_bucket) {
+    tsl_hh_assert(empty_bucket.empty());
+    if (!empty()) {
+      std::memcpy(std::addressof(empty_bucket.m_value),
+                  std::addressof(m_value), sizeof(value_type));
+      empty_bucket.copy_hash(*this);
+      empty_bucket.set_empty(false);
+      set_empty(true);
+    }
+  }
+
+  void remove_value() noexcept { set_empty(true); }
+
+  void clear() noexcept { store_infos(0); }
+
+  static truncated_hash_type truncate_hash(std::size_t hash) noexcept {
+    return truncated_hash_type(hash);
+  }
+
+ private:
+  neighborhood_bitmap load_infos() const noexcept {
+    neighborhood_bitmap infos;
+    std::memcpy(&infos, m_neighborhood_infos, sizeof(infos));
+    return infos;
+  }
+
+  void store_infos(neighborhood_bitmap infos) noexcept {
+    std::memcpy(m_neighborhood_infos, &infos, sizeof(infos));
+  }
+
+  void set_empty(bool is_empty) noexcept {
+    if (is_empty) {
+      store_infos(neighborhood_bitmap(load_infos() & ~1));
+    } else {
+      store_infos(neighborhood_bitmap(load_infos() | 1));
+    }
+  }
+
+  using storage = typename std::aligned_storage<sizeof(value_type),
+                                                alignof(value_type)>::type;
+
+  storage m_value;
+  unsigned char m_neighborhood_infos[sizeof(neighborhood_bitmap)];
+};
+
 /**
  * Internal common class used by (b)hopscotch_map and (b)hopscotch_set.
  *
@@ -408,11 +634,14 @@ class hopscotch_bucket : public hopscotch_bucket_hash<StoreHash> {
  * no value (in a set for example).
  *
  * OverflowContainer will be used as containers for overflown elements. Usually
- * it should be a list<ValueType> or a set<Key>/map<Key, T>.
+ * it should be a list<ValueType> or a set<Key>/map<Key, T>. A container
+ * defining hashed_overflow_tag (see hopscotch_overflow.h) is given the hash of
+ * the key on insertion and lookup.
  */
 template <class ValueType, class KeySelect, class ValueSelect, class Hash,
           class KeyEqual, class Allocator, unsigned int NeighborhoodSize,
-          bool StoreHash, class GrowthPolicy, class OverflowContainer>
+          bool StoreHash, class GrowthPolicy, class OverflowContainer,
+          bool CompactBuckets = false>
 class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
  private:
   template <typename U>
@@ -444,9 +673,12 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
   using const_iterator = hopscotch_iterator<true>;
 
  private:
-  using hopscotch_bucket =
+  using hopscotch_bucket = typename std::conditional<
+      CompactBuckets,
+      tsl::detail_hopscotch_hash::hopscotch_compact_bucket<
+          ValueType, NeighborhoodSize, StoreHash>,
       tsl::detail_hopscotch_hash::hopscotch_bucket<ValueType, NeighborhoodSize,
-                                                   StoreHash>;
+                                                   StoreHash>>::type;
   using neighborhood_bitmap = typename hopscotch_bucket::neighborhood_bitmap;
 
   using buckets_allocator = typename std::allocator_traits<
@@ -682,7 +914,9 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
         m_nb_elements(other.m_nb_elements),
         m_min_load_threshold_rehash(other.m_min_load_threshold_rehash),
         m_max_load_threshold_rehash(other.m_max_load_threshold_rehash),
-        m_max_load_factor(other.m_max_load_factor) {}
+        m_max_load_factor(other.m_max_load_factor),
+        m_build_threads(other.m_build_threads),
+        m_counters(other.m_counters) {}
 
   hopscotch_hash(hopscotch_hash&& other) noexcept(
       std::is_nothrow_move_constructible<Hash>::value&&
@@ -701,7 +935,9 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
         m_nb_elements(other.m_nb_elements),
         m_min_load_threshold_rehash(other.m_min_load_threshold_rehash),
         m_max_load_threshold_rehash(other.m_max_load_threshold_rehash),
-        m_max_load_factor(other.m_max_load_factor) {
+        m_max_load_factor(other.m_max_load_factor),
+        m_build_threads(other.m_build_threads),
+        m_counters(other.m_counters) {
     other.GrowthPolicy::clear();
     other.m_buckets_data.clear();
     other.m_overflow_elements.clear();
@@ -726,6 +962,8 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
       m_min_load_threshold_rehash = other.m_min_load_threshold_rehash;
       m_max_load_threshold_rehash = other.m_max_load_threshold_rehash;
       m_max_load_factor = other.m_max_load_factor;
+      m_build_threads = other.m_build_threads;
+      m_counters = other.m_counters;
     }
 
     return *this;
@@ -861,6 +1099,85 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
   }
 
+  /**
+   * Insert count elements: key_at(i) is the key of element i and value_at(i)
+   * returns the value_type to store for it. If the key is already in the map
+   * (or appeared earlier in the batch), on_existing(iterator, i) is called
+   * with the element holding it instead.
+   *
+   * The table is sized for all the elements up front. When the table is
+   * empty, build_threads() > 1 and there are at least
+   * PARALLEL_BUILD_MIN_ELEMENTS elements, the elements are split by the bucket
+   * range holding their home bucket and every range is filled by its own
+   * thread, see insert_partitioned. key_at, value_at, on_existing and the
+   * hash function are then called concurrently.
+   */
+  template <class KeyAt, class ValueAt, class OnExisting>
+  void bulk_insert(size_type count, KeyAt&& key_at, ValueAt&& value_at,
+                   OnExisting&& on_existing) {
+    const std::size_t nb_elements_in_buckets =
+        m_nb_elements - m_overflow_elements.size();
+    tsl_hh_assert(m_max_load_threshold_rehash >= nb_elements_in_buckets);
+    if (count > m_max_load_threshold_rehash - nb_elements_in_buckets) {
+      reserve(nb_elements_in_buckets + count);
+    }
+
+    const auto insert_one = [&](size_type i) {
+      const std::size_t hash = hash_key(key_at(i));
+      const std::size_t ibucket_for_hash = bucket_for_hash(hash);
+      auto it_find = find_impl(key_at(i), hash, m_buckets + ibucket_for_hash);
+      if (it_find != end()) {
+        on_existing(it_find, i);
+      } else {
+        insert_value(ibucket_for_hash, hash, value_at(i));
+      }
+    };
+
+    if (m_nb_elements != 0 || !use_parallel_build(count)) {
+      for (size_type i = 0; i < count; i++) {
+        insert_one(i);
+      }
+      return;
+    }
+
+    std::vector<size_type> deferred;
+    insert_partitioned(
+        count,
+        [&](size_type i, std::size_t& hash) {
+          hash = hash_key(key_at(i));
+          return true;
+        },
+        [&](size_type i, std::size_t hash, std::size_t ibucket_for_hash) {
+          // Walk the neighborhood bits rather than calling find_in_buckets,
+          // whose fingerprint scan reads buckets of the next range.
+          neighborhood_bitmap neighborhood_infos =
+              m_buckets[ibucket_for_hash].neighborhood_infos();
+          for (std::size_t ibucket = ibucket_for_hash; neighborhood_infos != 0;
+               ibucket++, neighborhood_infos >>= 1) {
+            if ((neighborhood_infos & 1) == 1 &&
+                (!StoreHash || m_buckets[ibucket].bucket_hash_equal(hash)) &&
+                compare_keys(KeySelect()(m_buckets[ibucket].value()),
+                             key_at(i))) {
+              on_existing(iterator(m_buckets_data.begin() + ibucket,
+                                   m_buckets_data.end(),
+                                   m_overflow_elements.begin()),
+                          i);
+              return true;
+            }
+          }
+          return false;
+        },
+        [&](hopscotch_bucket& bucket, std::size_t hash, size_type i) {
+          bucket.set_value_of_empty_bucket(
+              hopscotch_bucket::truncate_hash(hash), value_at(i));
+        },
+        deferred);
+
+    for (size_type i : deferred) {
+      insert_one(i);
+    }
+  }
+
   template <class M>
   std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj) {
     return insert_or_assign_impl(k, std::forward<M>(obj));
@@ -963,8 +1280,14 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
       return mutable_iterator(first);
     }
 
+    /*
+     * Erasing from a flat overflow container shifts the elements after the
+     * erased one, last may then point past the end of the overflow. Erase as
+     * many elements as the range holds instead of comparing against last.
+     */
+    auto remaining = std::distance(first, last);
     auto to_delete = erase(first);
-    while (to_delete != last) {
+    while (--remaining > 0) {
       to_delete = erase(to_delete);
     }
 
@@ -989,7 +1312,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
 
     if (m_buckets[ibucket_for_hash].has_overflow()) {
-      auto it_overflow = find_in_overflow(key);
+      auto it_overflow = find_in_overflow(key, hash);
       if (it_overflow != m_overflow_elements.end()) {
         erase_from_overflow(it_overflow, ibucket_for_hash);
 
@@ -1013,6 +1336,8 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     swap(m_min_load_threshold_rehash, other.m_min_load_threshold_rehash);
     swap(m_max_load_threshold_rehash, other.m_max_load_threshold_rehash);
     swap(m_max_load_factor, other.m_max_load_factor);
+    swap(m_build_threads, other.m_build_threads);
+    swap(m_counters, other.m_counters);
   }
 
   /*
@@ -1110,6 +1435,45 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     return count(key, hash) != 0;
   }
 
+  /**
+   * Look up count keys and call visitor(i, element) for each of them, element
+   * being a pointer to the value_type stored for keys[i] or nullptr.
+   *
+   * The home bucket of each key is hashed and prefetched FIND_BATCH_WINDOW
+   * keys before its lookup runs, so the cache misses of independent keys
+   * overlap instead of being paid one after the other. The visitor must not
+   * modify the map.
+   */
+  template <class K, class Visitor>
+  void find_batch(const K* keys, size_type count, Visitor&& visitor) const {
+    // Ring of the hashes computed ahead, FIND_BATCH_WINDOW is a power of two
+    std::size_t hashes[FIND_BATCH_WINDOW];
+    const size_type mask = size_type(FIND_BATCH_WINDOW) - 1;
+    const size_type ahead = std::min(count, size_type(FIND_BATCH_WINDOW));
+    for (size_type i = 0; i < ahead; i++) {
+      hashes[i] = hash_key(keys[i]);
+      TSL_HH_PREFETCH(m_buckets + bucket_for_hash(hashes[i]));
+    }
+    for (size_type i = 0; i < count; i++) {
+      const std::size_t hash = hashes[i & mask];
+      const size_type next = i + size_type(FIND_BATCH_WINDOW);
+      if (next < count) {
+        hashes[next & mask] = hash_key(keys[next]);
+        TSL_HH_PREFETCH(m_buckets + bucket_for_hash(hashes[next & mask]));
+      }
+      visitor(i, find_element(keys[i], hash));
+    }
+  }
+
+  /**
+   * Address of the home bucket of a key with the given hash, for callers
+   * scheduling their own prefetches before a find(key, hash). The bucket must
+   * not be accessed through the pointer.
+   */
+  const void* home_bucket_address(std::size_t hash) const noexcept {
+    return m_buckets + bucket_for_hash(hash);
+  }
+
   template <class K>
   std::pair<iterator, iterator> equal_range(const K& key) {
     return equal_range(key, hash_key(key));
@@ -1187,6 +1551,18 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     rehash(size_type(std::ceil(float(count_) / max_load_factor())));
   }
 
+  /**
+   * Number of threads rehash and bulk_insert may use on tables of at least
+   * PARALLEL_BUILD_MIN_ELEMENTS elements. 1, the default, keeps all the work
+   * on the calling thread. The hash function must then be callable from
+   * several threads at once.
+   */
+  void set_build_threads(std::size_t threads) noexcept {
+    m_build_threads = std::max<std::size_t>(threads, 1);
+  }
+
+  std::size_t build_threads() const noexcept { return m_build_threads; }
+
   /*
    * Observers
    */
@@ -1214,6 +1590,86 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     return m_overflow_elements.size();
   }
 
+  const overflow_container_type& overflow_container() const noexcept {
+    return m_overflow_elements;
+  }
+
+  /**
+   * Occupancy of the table, computed from the neighborhood bitmaps in one pass
+   * over the buckets, and the insertion counters.
+   */
+  tsl::hh::hopscotch_statistics statistics() const {
+    tsl::hh::hopscotch_statistics stats;
+    stats.size = size();
+    stats.bucket_count = bucket_count();
+    stats.load_factor = load_factor();
+    stats.overflow_size = overflow_size();
+    stats.distance_histogram.assign(NeighborhoodSize, 0);
+
+    // Elements in the window [ibucket, ibucket + NeighborhoodSize)
+    std::size_t window_elements = 0;
+    for (std::size_t ibucket = 0;
+         ibucket < NeighborhoodSize && ibucket < m_buckets_data.size();
+         ibucket++) {
+      window_elements += m_buckets[ibucket].empty() ? 0 : 1;
+    }
+
+    std::size_t home_buckets = 0;
+    double occupancy_sum = 0;
+    for (std::size_t ibucket = 0; ibucket < m_buckets_data.size(); ibucket++) {
+      neighborhood_bitmap neighborhood_infos =
+          m_buckets[ibucket].neighborhood_infos();
+      if (neighborhood_infos != 0) {
+        home_buckets++;
+        occupancy_sum += double(window_elements) / NeighborhoodSize;
+      }
+      for (std::size_t distance = 0; neighborhood_infos != 0;
+           distance++, neighborhood_infos >>= 1) {
+        stats.distance_histogram[distance] += neighborhood_infos & 1;
+      }
+
+      window_elements -= m_buckets[ibucket].empty() ? 0 : 1;
+      if (ibucket + NeighborhoodSize < m_buckets_data.size()) {
+        window_elements +=
+            m_buckets[ibucket + NeighborhoodSize].empty() ? 0 : 1;
+      }
+    }
+    stats.average_neighborhood_occupancy =
+        home_buckets != 0 ? occupancy_sum / double(home_buckets) : 0.0;
+
+    stats.bucket_inserts = m_counters.bucket_inserts;
+    stats.overflow_inserts = m_counters.overflow_inserts;
+    stats.displacements = m_counters.displacements;
+    stats.max_displacements = m_counters.max_displacements;
+    stats.load_rehashes = m_counters.load_rehashes;
+    stats.neighborhood_rehashes = m_counters.neighborhood_rehashes;
+    return stats;
+  }
+
+  /**
+   * Call visitor(neighborhood_bitmap, has_overflow, value) for every bucket of
+   * the bucket array in order, including the NeighborhoodSize - 1 trailing
+   * buckets. value is nullptr for an empty bucket. Bit i of the bitmap tells
+   * that the bucket i positions further holds an element hashing here.
+   */
+  template <class Visitor>
+  void visit_buckets(Visitor&& visitor) const {
+    for (const hopscotch_bucket& bucket : m_buckets_data) {
+      visitor(bucket.neighborhood_infos(), bucket.has_overflow(),
+              bucket.empty() ? nullptr : std::addressof(bucket.value()));
+    }
+  }
+
+  /**
+   * Call visitor(value) for every element stored in the overflow container.
+   */
+  template <class Visitor>
+  void visit_overflow(Visitor&& visitor) const {
+    for (const value_type& value : m_overflow_elements) {
+      visitor(value);
+    }
+  }
+
   template <class U = OverflowContainer,
             typename std::enable_if<has_key_compare<U>::value>::type* = nullptr>
   typename U::key_compare key_comp() const {
@@ -1244,6 +1700,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
                 std::is_nothrow_move_constructible<U>::value>::type* = nullptr>
   void rehash_impl(size_type count_) {
     hopscotch_hash new_map = new_hopscotch_hash(count_);
+    new_map.m_build_threads = m_build_threads;
 
     if (!m_overflow_elements.empty()) {
       new_map.m_overflow_elements.swap(m_overflow_elements);
@@ -1256,11 +1713,46 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
       }
     }
 
+    const insert_counters counters = m_counters;
+    bool moved_in_parallel = false;
 #ifndef TSL_HH_NO_EXCEPTIONS
     try {
 #endif
       const bool use_stored_hash =
           USE_STORED_HASH_ON_REHASH(new_map.bucket_count());
+
+      /*
+       * Move most elements with several threads first. A moved element leaves
+       * its bucket empty without updating the neighborhood of its home bucket
+       * nor the element count; the loop below only looks at the buckets still
+       * holding an element, the catch rebuilds both if the elements must come
+       * back.
+       */
+      if (new_map.use_parallel_build(m_nb_elements - new_map.size())) {
+        moved_in_parallel = true;
+        std::vector<size_type> unplaced;
+        m_nb_elements -= new_map.insert_partitioned(
+            m_buckets_data.size(),
+            [&](size_type ibucket, std::size_t& hash) {
+              if (m_buckets[ibucket].empty()) {
+                return false;
+              }
+              const value_type& value = m_buckets[ibucket].value();
+              hash = use_stored_hash
+                         ? m_buckets[ibucket].truncated_bucket_hash()
+                         : new_map.hash_key(KeySelect()(value));
+              return true;
+            },
+            [](size_type, std::size_t, std::size_t) { return false; },
+            [&](hopscotch_bucket& bucket, std::size_t hash, size_type ibucket) {
+              bucket.set_value_of_empty_bucket(
+                  hopscotch_bucket::truncate_hash(hash),
+                  std::move(m_buckets[ibucket].value()));
+              m_buckets[ibucket].remove_value();
+            },
+            unplaced);
+      }
+
       for (auto it_bucket = m_buckets_data.begin();
            it_bucket != m_buckets_data.end(); ++it_bucket) {
         if (it_bucket->empty()) {
@@ -1281,11 +1773,21 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
     /*
      * The call to insert_value may throw an exception if an element is added to
-     * the overflow list and the memory allocation fails. Rollback the elements
+     * the overflow list and the memory allocation fails, insert_partitioned if
+     * a hash, an allocation or a thread creation fails. Rollback the elements
      * in this case.
      */
     catch (...) {
       m_overflow_elements.swap(new_map.m_overflow_elements);
+      if (moved_in_parallel) {
+        rebuild_neighborhoods();
+        m_nb_elements = m_overflow_elements.size();
+        for (const hopscotch_bucket& bucket : m_buckets_data) {
+          if (!bucket.empty()) {
+            m_nb_elements++;
+          }
+        }
+      }
 
       const bool use_stored_hash =
           USE_STORED_HASH_ON_REHASH(new_map.bucket_count());
@@ -1305,11 +1807,14 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
         // switch.
         insert_value(ibucket_for_hash, hash, std::move(it_bucket->value()));
       }
+      m_counters = counters;
 
       throw;
     }
 #endif
 
+    // The moves into new_map are not new inserts
+    new_map.m_counters = m_counters;
     new_map.swap(*this);
   }
 
@@ -1319,6 +1824,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
                 !std::is_nothrow_move_constructible<U>::value>::type* = nullptr>
   void rehash_impl(size_type count_) {
     hopscotch_hash new_map = new_hopscotch_hash(count_);
+    new_map.m_build_threads = m_build_threads;
 
     const bool use_stored_hash =
         USE_STORED_HASH_ON_REHASH(new_map.bucket_count());
@@ -1342,9 +1848,224 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
       new_map.insert_value(ibucket_for_hash, hash, value);
     }
 
+    // The moves into new_map are not new inserts
+    new_map.m_counters = m_counters;
     new_map.swap(*this);
   }
 
+  bool use_parallel_build(size_type nb_elements) const noexcept {
+    return m_build_threads > 1 &&
+           nb_elements >= PARALLEL_BUILD_MIN_ELEMENTS &&
+           bucket_count() / m_build_threads >=
+               PARALLEL_BUILD_MIN_BUCKETS_PER_THREAD;
+  }
+
+  /**
+   * Call work(thread) for thread in [0, threads), thread 0 on the calling
+   * thread. The first exception thrown by a call is rethrown once all of
+   * them have returned.
+   */
+  template <class Work>
+  static void run_build_threads(std::size_t threads, Work& work) {
+#ifndef TSL_HH_NO_EXCEPTIONS
+    std::vector<std::exception_ptr> errors(threads);
+    const auto guarded_work = [&](std::size_t thread) {
+      try {
+        work(thread);
+      } catch (...) {
+        errors[thread] = std::current_exception();
+      }
+    };
+#else
+    const auto guarded_work = [&](std::size_t thread) { work(thread); };
+#endif
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t thread = 1; thread < threads; thread++) {
+#ifndef TSL_HH_NO_EXCEPTIONS
+      try {
+        workers.emplace_back(guarded_work, thread);
+      } catch (...) {
+        // No thread available, do its share here
+        guarded_work(thread);
+      }
+#else
+      workers.emplace_back(guarded_work, thread);
+#endif
+    }
+    guarded_work(0);
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+
+#ifndef TSL_HH_NO_EXCEPTIONS
+    for (const std::exception_ptr& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+#endif
+  }
+
+  /**
+   * Place count elements in the buckets with m_build_threads threads and
+   * return how many were placed.
+   *
+   * The bucket array is cut into one range per thread and the elements are
+   * counting-sorted by the range holding their home bucket, keeping their
+   * order within a range. Every thread then places the elements of its
+   * range in the first empty bucket of their neighborhood, without
+   * displacing anything. A thread reads and writes only the buckets of its
+   * range, so the neighborhood of an element is cut at the end of the range:
+   * the elements finding no empty bucket before the range ends or the
+   * neighborhood does, and those whose home bucket overflows, are appended to
+   * deferred for the caller to insert the sequential way.
+   *
+   * hash_of(i, hash) sets the hash of element i, or returns false to skip it.
+   * present(i, hash, ibucket_for_hash) returns true if the element must not
+   * be inserted, and construct(bucket, hash, i) builds it in an empty bucket.
+   */
+  template <class HashOf, class Present, class Construct>
+  size_type insert_partitioned(size_type count, HashOf&& hash_of,
+                               Present&& present, Construct&& construct,
+                               std::vector<size_type>& deferred) {
+    const std::size_t threads = m_build_threads;
+    const std::size_t range_size = (bucket_count() + threads - 1) / threads;
+    const auto range_of = [&](size_type i, std::size_t& hash) {
+      if (!hash_of(i, hash)) {
+        return threads;
+      }
+      return std::min(bucket_for_hash(hash) / range_size, threads - 1);
+    };
+    const auto first_element = [&](std::size_t thread) {
+      return size_type(count / threads * thread +
+                       std::min<std::size_t>(thread, count % threads));
+    };
+
+    // Count the elements of every range in the slice of each thread
+    std::vector<size_type> offsets(threads * threads, 0);
+    auto count_ranges = [&](std::size_t thread) {
+      for (size_type i = first_element(thread); i < first_element(thread + 1);
+           i++) {
+        std::size_t hash = 0;
+        const std::size_t range = range_of(i, hash);
+        if (range < threads) {
+          offsets[thread * threads + range]++;
+        }
+      }
+    };
+    run_build_threads(threads, count_ranges);
+
+    // Ranges one after the other, slices in order within a range
+    std::vector<size_type> range_starts(threads + 1, 0);
+    size_type nb_sorted = 0;
+    for (std::size_t range = 0; range < threads; range++) {
+      range_starts[range] = nb_sorted;
+      for (std::size_t thread = 0; thread < threads; thread++) {
+        const size_type slice_count = offsets[thread * threads + range];
+        offsets[thread * threads + range] = nb_sorted;
+        nb_sorted += slice_count;
+      }
+    }
+    range_starts[threads] = nb_sorted;
+
+    std::vector<size_type> sorted(nb_sorted);
+    auto sort_ranges = [&](std::size_t thread) {
+      for (size_type i = first_element(thread); i < first_element(thread + 1);
+           i++) {
+        std::size_t hash = 0;
+        const std::size_t range = range_of(i, hash);
+        if (range < threads) {
+          sorted[offsets[thread * threads + range]++] = i;
+        }
+      }
+    };
+    run_build_threads(threads, sort_ranges);
+
+    std::vector<size_type> nb_placed(threads, 0);
+    std::vector<std::vector<size_type>> deferred_by_range(threads);
+    auto place_range = [&](std::size_t range) {
+      const std::size_t range_end =
+          range + 1 == threads ? m_buckets_data.size()
+                               : (range + 1) * range_size;
+      for (size_type k = range_starts[range]; k < range_starts[range + 1];
+           k++) {
+        const size_type i = sorted[k];
+        std::size_t hash = 0;
+        if (!hash_of(i, hash)) {
+          continue;
+        }
+        const std::size_t ibucket_for_hash = bucket_for_hash(hash);
+        if (m_buckets[ibucket_for_hash].has_overflow()) {
+          deferred_by_range[range].push_back(i);
+          continue;
+        }
+        if (present(i, hash, ibucket_for_hash)) {
+          continue;
+        }
+
+        const std::size_t limit =
+            std::min(ibucket_for_hash + NeighborhoodSize, range_end);
+        std::size_t ibucket_empty = ibucket_for_hash;
+        while (ibucket_empty < limit && !m_buckets[ibucket_empty].empty()) {
+          ibucket_empty++;
+        }
+        if (ibucket_empty == limit) {
+          deferred_by_range[range].push_back(i);
+          continue;
+        }
+
+        construct(m_buckets[ibucket_empty], hash, i);
+        m_buckets[ibucket_for_hash].toggle_neighbor_presence(ibucket_empty -
+                                                             ibucket_for_hash);
+        nb_placed[range]++;
+      }
+    };
+
+    size_type total_placed = 0;
+#ifndef TSL_HH_NO_EXCEPTIONS
+    try {
+#endif
+      run_build_threads(threads, place_range);
+#ifndef TSL_HH_NO_EXCEPTIONS
+    } catch (...) {
+      for (size_type placed : nb_placed) {
+        m_nb_elements += placed;
+      }
+      throw;
+    }
+#endif
+
+    for (std::size_t range = 0; range < threads; range++) {
+      total_placed += nb_placed[range];
+      deferred.insert(deferred.end(), deferred_by_range[range].begin(),
+                      deferred_by_range[range].end());
+    }
+    m_nb_elements += total_placed;
+    m_counters.bucket_inserts += total_placed;
+    return total_placed;
+  }
+
+  /**
+   * Recompute every neighborhood bitmap from the elements in the buckets.
+   * Rehashes the keys, so it may throw if Hash does.
+   */
+  void rebuild_neighborhoods() {
+    for (hopscotch_bucket& bucket : m_buckets_data) {
+      bucket.clear_neighborhood();
+    }
+    for (std::size_t ibucket = 0; ibucket < m_buckets_data.size(); ibucket++) {
+      if (m_buckets[ibucket].empty()) {
+        continue;
+      }
+      const std::size_t ibucket_for_hash =
+          bucket_for_hash(hash_key(KeySelect()(m_buckets[ibucket].value())));
+      m_buckets[ibucket_for_hash].toggle_neighbor_presence(ibucket -
+                                                           ibucket_for_hash);
+    }
+  }
+
 #ifdef TSL_HH_NO_RANGE_ERASE_WITH_CONST_ITERATOR
   iterator_overflow mutable_overflow_iterator(const_iterator_overflow it) {
     return std::next(m_overflow_elements.begin(),
@@ -1444,11 +2165,13 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
                                          Args&&... value_type_args) {
     if ((m_nb_elements - m_overflow_elements.size()) >=
         m_max_load_threshold_rehash) {
+      m_counters.load_rehashes++;
       rehash(GrowthPolicy::next_bucket_count());
       ibucket_for_hash = bucket_for_hash(hash);
     }
 
     std::size_t ibucket_empty = find_empty_bucket(ibucket_for_hash);
+    const std::size_t displacements_before = m_counters.displacements;
     if (ibucket_empty < m_buckets_data.size()) {
       do {
         tsl_hh_assert(ibucket_empty >= ibucket_for_hash);
@@ -1457,6 +2180,8 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
         if (ibucket_empty - ibucket_for_hash < NeighborhoodSize) {
           auto it = insert_in_bucket(ibucket_empty, ibucket_for_hash, hash,
                                      std::forward<Args>(value_type_args)...);
+          count_bucket_insert(m_counters.displacements -
+                              displacements_before);
           return std::make_pair(
               iterator(it, m_buckets_data.end(), m_overflow_elements.begin()),
               true);
@@ -1470,12 +2195,14 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     // the value in overflow list
     if (size() < m_min_load_threshold_rehash ||
         !will_neighborhood_change_on_rehash(ibucket_for_hash)) {
-      auto it = insert_in_overflow(ibucket_for_hash,
+      auto it = insert_in_overflow(ibucket_for_hash, hash,
                                    std::forward<Args>(value_type_args)...);
+      m_counters.overflow_inserts++;
       return std::make_pair(
           iterator(m_buckets_data.end(), m_buckets_data.end(), it), true);
     }
 
+    m_counters.neighborhood_rehashes++;
     rehash(GrowthPolicy::next_bucket_count());
     ibucket_for_hash = bucket_for_hash(hash);
 
@@ -1483,6 +2210,12 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
                         std::forward<Args>(value_type_args)...);
   }
 
+  void count_bucket_insert(std::size_t displacements) noexcept {
+    m_counters.bucket_inserts++;
+    m_counters.max_displacements =
+        std::max(m_counters.max_displacements, displacements);
+  }
+
   /*
    * Return true if a rehash will change the position of a key-value in the
    * neighborhood of ibucket_neighborhood_check. In this case a rehash is needed
@@ -1552,10 +2285,12 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     return m_buckets_data.begin() + ibucket_empty;
   }
 
-  template <
-      class... Args, class U = OverflowContainer,
-      typename std::enable_if<!has_key_compare<U>::value>::type* = nullptr>
+  template <class... Args, class U = OverflowContainer,
+            typename std::enable_if<!has_key_compare<U>::value &&
+                                    !is_hashed_overflow<U>::value>::type* =
+                nullptr>
   iterator_overflow insert_in_overflow(std::size_t ibucket_for_hash,
+                                       std::size_t /*hash*/,
                                        Args&&... value_type_args) {
     auto it = m_overflow_elements.emplace(
         m_overflow_elements.end(), std::forward<Args>(value_type_args)...);
@@ -1566,9 +2301,35 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     return it;
   }
 
+  template <
+      class... Args, class U = OverflowContainer,
+      typename std::enable_if<is_hashed_overflow<U>::value>::type* = nullptr>
+  iterator_overflow insert_in_overflow(std::size_t ibucket_for_hash,
+                                       std::size_t hash,
+                                       Args&&... value_type_args) {
+    auto it = m_overflow_elements.emplace_hashed(
+        overflow_hash(hash), std::forward<Args>(value_type_args)...);
+
+    m_buckets[ibucket_for_hash].set_overflow(true);
+    m_nb_elements++;
+
+    return it;
+  }
+
+  /**
+   * Hash stored in and looked up from a hashed overflow container. With
+   * StoreHash a rehash only knows the truncated hash of an element, so both
+   * sides use the truncated hash.
+   */
+  static std::size_t overflow_hash(std::size_t hash) noexcept {
+    return StoreHash ? std::size_t(hopscotch_bucket::truncate_hash(hash))
+                     : hash;
+  }
+
   template <class... Args, class U = OverflowContainer,
             typename std::enable_if<has_key_compare<U>::value>::type* = nullptr>
   iterator_overflow insert_in_overflow(std::size_t ibucket_for_hash,
+                                       std::size_t /*hash*/,
                                        Args&&... value_type_args) {
     auto it =
         m_overflow_elements.emplace(std::forward<Args>(value_type_args)...)
@@ -1616,6 +2377,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
           m_buckets[to_check].toggle_neighbor_presence(to_swap - to_check);
 
           ibucket_empty_in_out = to_swap;
+          m_counters.displacements++;
 
           return true;
         }
@@ -1656,7 +2418,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
 
     if (bucket_for_hash->has_overflow()) {
-      auto it_overflow = find_in_overflow(key);
+      auto it_overflow = find_in_overflow(key, hash);
       if (it_overflow != m_overflow_elements.end()) {
         return std::addressof(ValueSelect()(*it_overflow));
       }
@@ -1671,7 +2433,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     if (find_in_buckets(key, hash, bucket_for_hash) != nullptr) {
       return 1;
     } else if (bucket_for_hash->has_overflow() &&
-               find_in_overflow(key) != m_overflow_elements.cend()) {
+               find_in_overflow(key, hash) != m_overflow_elements.cend()) {
       return 1;
     } else {
       return 0;
@@ -1694,7 +2456,7 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
 
     return iterator(m_buckets_data.end(), m_buckets_data.end(),
-                    find_in_overflow(key));
+                    find_in_overflow(key, hash));
   }
 
   template <class K>
@@ -1714,7 +2476,25 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     }
 
     return const_iterator(m_buckets_data.cend(), m_buckets_data.cend(),
-                          find_in_overflow(key));
+                          find_in_overflow(key, hash));
+  }
+
+  template <class K>
+  const value_type* find_element(const K& key, std::size_t hash) const {
+    const hopscotch_bucket* home = m_buckets + bucket_for_hash(hash);
+    const hopscotch_bucket* bucket_found = find_in_buckets(key, hash, home);
+    if (bucket_found != nullptr) {
+      return std::addressof(bucket_found->value());
+    }
+
+    if (!home->has_overflow()) {
+      return nullptr;
+    }
+
+    auto it_overflow = find_in_overflow(key, hash);
+    return it_overflow == m_overflow_elements.cend()
+               ? nullptr
+               : std::addressof(*it_overflow);
   }
 
   template <class K>
@@ -1735,6 +2515,15 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
       const hopscotch_bucket* bucket_for_hash) const {
     (void)hash;  // Avoid warning of unused variable when StoreHash is false;
 
+#ifdef TSL_HH_AVX2_FINGERPRINTS
+    if (StoreHash && __builtin_popcountll(bucket_for_hash->neighborhood_infos()) >=
+                         MIN_NEIGHBORS_FOR_FINGERPRINT_SCAN) {
+      return find_in_buckets_by_fingerprint(
+          key, hash, bucket_for_hash,
+          std::integral_constant<bool, StoreHash>());
+    }
+#endif
+
     // TODO Try to optimize the function.
     // I tried to use ffs and  __builtin_ffs functions but I could not reduce
     // the time the function takes with -march=native
@@ -1760,20 +2549,89 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
     return nullptr;
   }
 
-  template <
-      class K, class U = OverflowContainer,
-      typename std::enable_if<!has_key_compare<U>::value>::type* = nullptr>
-  iterator_overflow find_in_overflow(const K& key) {
+#ifdef TSL_HH_AVX2_FINGERPRINTS
+  /**
+   * With StoreHash, compare the truncated hash of eight neighborhood buckets
+   * at once: gather the stored hashes of the buckets whose neighborhood bit
+   * is set and compare them to the query's. Keys are only compared for the
+   * matching lanes, which saves most key comparisons for expensive keys.
+   */
+  template <class K>
+  const hopscotch_bucket* find_in_buckets_by_fingerprint(
+      const K& key, std::size_t hash, const hopscotch_bucket* bucket_for_hash,
+      std::true_type /*store_hash*/) const {
+    static_assert(sizeof(truncated_hash_type) == sizeof(int),
+                  "Fingerprint lanes are 32 bits.");
+    static_assert(sizeof(hopscotch_bucket) % sizeof(int) == 0,
+                  "Buckets must be a whole number of lanes apart.");
+    const int stride = int(sizeof(hopscotch_bucket) / sizeof(int));
+
+    const __m256i lane_indexes = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+    const __m256i lane_bits =
+        _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i fingerprint = _mm256_set1_epi32(int(truncated_hash_type(hash)));
+
+    std::uint64_t neighborhood_infos = bucket_for_hash->neighborhood_infos();
+    for (std::size_t offset = 0; neighborhood_infos != 0;
+         offset += 8, neighborhood_infos >>= 8) {
+      const int lanes = int(neighborhood_infos & 0xFF);
+      if (lanes == 0) {
+        continue;
+      }
+      const hopscotch_bucket* group = bucket_for_hash + offset;
+
+      // Lanes outside the neighborhood are masked off and never loaded
+      const __m256i load_mask = _mm256_cmpeq_epi32(
+          _mm256_and_si256(_mm256_set1_epi32(lanes), lane_bits), lane_bits);
+      const __m256i hashes = _mm256_mask_i32gather_epi32(
+          _mm256_setzero_si256(),
+          reinterpret_cast<const int*>(group->truncated_bucket_hash_address()),
+          lane_indexes, load_mask, 4);
+      unsigned int matches =
+          unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(
+              _mm256_cmpeq_epi32(hashes, fingerprint)))) &
+          unsigned(lanes);
+
+      while (matches != 0) {
+        const hopscotch_bucket* bucket = group + __builtin_ctz(matches);
+        if (compare_keys(KeySelect()(bucket->value()), key)) {
+          return bucket;
+        }
+        matches &= matches - 1;
+      }
+    }
+
+    return nullptr;
+  }
+
+  template <class K>
+  const hopscotch_bucket* find_in_buckets_by_fingerprint(
+      const K& /*key*/, std::size_t /*hash*/,
+      const hopscotch_bucket* /*bucket_for_hash*/,
+      std::false_type /*store_hash*/) const {
+    // Only called when StoreHash is true
+    return nullptr;
+  }
+#endif
+
+  template <class K, class U = OverflowContainer,
+            typename std::enable_if<!has_key_compare<U>::value &&
+                                    !is_hashed_overflow<U>::value>::type* =
+                nullptr>
+  iterator_overflow find_in_overflow(const K& key, std::size_t /*hash*/) {
     return std::find_if(m_overflow_elements.begin(), m_overflow_elements.end(),
                         [&](const value_type& value) {
                           return compare_keys(key, KeySelect()(value));
                         });
   }
 
-  template <
-      class K, class U = OverflowContainer,
-      typename std::enable_if<!has_key_compare<U>::value>::type* = nullptr>
-  const_iterator_overflow find_in_overflow(const K& key) const {
+  template <class K, class U = OverflowContainer,
+            typename std::enable_if<!has_key_compare<U>::value &&
+                                    !is_hashed_overflow<U>::value>::type* =
+                nullptr>
+  const_iterator_overflow find_in_overflow(const K& key,
+                                           std::size_t /*hash*/) const {
     return std::find_if(m_overflow_elements.cbegin(),
                         m_overflow_elements.cend(),
                         [&](const value_type& value) {
@@ -1781,15 +2639,37 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
                         });
   }
 
+  template <
+      class K, class U = OverflowContainer,
+      typename std::enable_if<is_hashed_overflow<U>::value>::type* = nullptr>
+  iterator_overflow find_in_overflow(const K& key, std::size_t hash) {
+    return m_overflow_elements.find(
+        overflow_hash(hash), [&](const value_type& value) {
+          return compare_keys(key, KeySelect()(value));
+        });
+  }
+
+  template <
+      class K, class U = OverflowContainer,
+      typename std::enable_if<is_hashed_overflow<U>::value>::type* = nullptr>
+  const_iterator_overflow find_in_overflow(const K& key,
+                                           std::size_t hash) const {
+    return m_overflow_elements.find(
+        overflow_hash(hash), [&](const value_type& value) {
+          return compare_keys(key, KeySelect()(value));
+        });
+  }
+
   template <class K, class U = OverflowContainer,
             typename std::enable_if<has_key_compare<U>::value>::type* = nullptr>
-  iterator_overflow find_in_overflow(const K& key) {
+  iterator_overflow find_in_overflow(const K& key, std::size_t /*hash*/) {
     return m_overflow_elements.find(key);
   }
 
   template <class K, class U = OverflowContainer,
             typename std::enable_if<has_key_compare<U>::value>::type* = nullptr>
-  const_iterator_overflow find_in_overflow(const K& key) const {
+  const_iterator_overflow find_in_overflow(const K& key,
+                                           std::size_t /*hash*/) const {
     return m_overflow_elements.find(key);
   }
 
@@ -1812,12 +2692,34 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
 
  public:
   static const size_type DEFAULT_INIT_BUCKETS_SIZE = 0;
+  /**
+   * Prefetch distance of find_batch, a power of two: enough keys to cover
+   * the memory latency, few enough that the prefetched lines stay in L1.
+   */
+  static const size_type FIND_BATCH_WINDOW = 16;
+  /**
+   * Smallest rehash or bulk_insert spread over the build threads, below it
+   * starting the threads costs more than they save.
+   */
+  static const size_type PARALLEL_BUILD_MIN_ELEMENTS = 1 << 16;
+  /**
+   * Bucket range a build thread must at least own, so that few elements see
+   * their neighborhood cut by the end of a range.
+   */
+  static const size_type PARALLEL_BUILD_MIN_BUCKETS_PER_THREAD = 1 << 12;
   static constexpr float DEFAULT_MAX_LOAD_FACTOR =
       (NeighborhoodSize <= 30) ? 0.8f : 0.9f;
 
  private:
   static const std::size_t MAX_PROBES_FOR_EMPTY_BUCKET = 12 * NeighborhoodSize;
   static constexpr float MIN_LOAD_FACTOR_FOR_REHASH = 0.1f;
+#ifdef TSL_HH_AVX2_FINGERPRINTS
+  /**
+   * A gather costs more than a few scalar fingerprint checks, only scan
+   * neighborhoods holding at least this many elements with AVX2.
+   */
+  static const int MIN_NEIGHBORS_FOR_FINGERPRINT_SCAN = 4;
+#endif
 
   /**
    * We can only use the hash on rehash if the size of the hash type is the same
@@ -1885,6 +2787,25 @@ class hopscotch_hash : private Hash, private KeyEqual, private GrowthPolicy {
   size_type m_max_load_threshold_rehash;
 
   float m_max_load_factor;
+
+  /**
+   * Threads rehash and bulk_insert may use, see set_build_threads.
+   */
+  std::size_t m_build_threads = 1;
+
+  /**
+   * Insertion counters reported by statistics(), carried over by rehash.
+   */
+  struct insert_counters {
+    std::size_t bucket_inserts = 0;
+    std::size_t overflow_inserts = 0;
+    std::size_t displacements = 0;
+    std::size_t max_displacements = 0;
+    std::size_t load_rehashes = 0;
+    std::size_t neighborhood_rehashes = 0;
+  };
+
+  insert_counters m_counters;
 };
 
 }  // end namespace detail_hopscotch_hash
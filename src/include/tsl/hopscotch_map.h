@@ -34,6 +34,7 @@
 #include <utility>
 
 #include "hopscotch_hash.h"
+#include "hopscotch_overflow.h"
 
 namespace tsl {
 
@@ -63,6 +64,18 @@ namespace tsl {
  * map the hash to a bucket instead of the slow modulo. You may define your own
  * growth policy, check tsl::power_of_two_growth_policy for the interface.
  *
+ * OverflowContainer stores the elements which do not fit in the neighborhood
+ * of their bucket. The default std::list is scanned linearly on lookup;
+ * tsl::hh::vector_overflow and tsl::hh::indexed_overflow keep them contiguous
+ * and search them by hash, see hopscotch_overflow.h.
+ *
+ * CompactBuckets, for a value_type that is trivially copy constructible and
+ * trivially destructible (e.g. std::pair<int, int>), stores the neighborhood
+ * bitmap unaligned after the element so that a bucket is only aligned as the
+ * element, and makes the buckets trivially copyable: copies and rehashes move
+ * them with memcpy. It pays off with a NeighborhoodSize small enough for a
+ * narrow bitmap, e.g. 30 (or 14) instead of 62 for std::pair<int, int>.
+ *
  * If the destructors of Key or T throw an exception, behaviour of the class is
  * undefined.
  *
@@ -73,13 +86,17 @@ namespace tsl {
  * collision (which mean that most of the time, insert will invalidate the
  * iterators). Or if there is a rehash.
  *  - erase: iterator on the erased element is the only one which become
- * invalid.
+ * invalid. With tsl::hh::vector_overflow or tsl::hh::indexed_overflow as
+ * OverflowContainer, erasing an overflown element also invalidates the
+ * iterators on the other overflown elements.
  */
 template <class Key, class T, class Hash = std::hash<Key>,
           class KeyEqual = std::equal_to<Key>,
           class Allocator = std::allocator<std::pair<Key, T>>,
           unsigned int NeighborhoodSize = 62, bool StoreHash = false,
-          class GrowthPolicy = tsl::hh::power_of_two_growth_policy<2>>
+          class GrowthPolicy = tsl::hh::power_of_two_growth_policy<2>,
+          class OverflowContainer = std::list<std::pair<Key, T>, Allocator>,
+          bool CompactBuckets = false>
 class hopscotch_map {
  private:
   template <typename U>
@@ -111,10 +128,11 @@ class hopscotch_map {
     }
   };
 
-  using overflow_container_type = std::list<std::pair<Key, T>, Allocator>;
+  using overflow_container_type = OverflowContainer;
   using ht = detail_hopscotch_hash::hopscotch_hash<
       std::pair<Key, T>, KeySelect, ValueSelect, Hash, KeyEqual, Allocator,
-      NeighborhoodSize, StoreHash, GrowthPolicy, overflow_container_type>;
+      NeighborhoodSize, StoreHash, GrowthPolicy, overflow_container_type,
+      CompactBuckets>;
 
  public:
   using key_type = typename ht::key_type;
@@ -259,6 +277,20 @@ class hopscotch_map {
     m_ht.insert(ilist.begin(), ilist.end());
   }
 
+  /**
+   * Insert the count pairs (keys[i], values[i]). A key already in the map, or
+   * repeated in keys, takes the last of its values, as with operator[].
+   *
+   * The map is reserved for all the pairs at once and, on an empty map with
+   * build_threads() > 1, filled by several threads (see set_build_threads).
+   */
+  void bulk_load(const Key* keys, const T* values, size_type count) {
+    m_ht.bulk_insert(
+        count, [keys](size_type i) -> const Key& { return keys[i]; },
+        [keys, values](size_type i) { return value_type(keys[i], values[i]); },
+        [values](iterator it, size_type i) { it.value() = values[i]; });
+  }
+
   template <class M>
   std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj) {
     return m_ht.insert_or_assign(k, std::forward<M>(obj));
@@ -496,6 +528,28 @@ class hopscotch_map {
     return m_ht.find(key, precalculated_hash);
   }
 
+  /**
+   * Look up count keys at once, values[i] is set to the value mapped to
+   * keys[i] or nullptr. Home buckets are prefetched a window of keys ahead,
+   * overlapping the cache misses of independent lookups.
+   */
+  void find_batch(const Key* keys, size_type count, const T** values) const {
+    m_ht.find_batch(keys, count,
+                    [values](size_type i, const value_type* element) {
+                      values[i] =
+                          element == nullptr ? nullptr : &element->second;
+                    });
+  }
+
+  /**
+   * Address of the home bucket for the hash value 'precalculated_hash', to be
+   * prefetched before find(key, precalculated_hash).
+   */
+  const void* home_bucket_address(
+      std::size_t precalculated_hash) const noexcept {
+    return m_ht.home_bucket_address(precalculated_hash);
+  }
+
   /**
    * This overload only participates in the overload resolution if the typedef
    * KeyEqual::is_transparent exists. If so, K must be hashable and comparable
@@ -673,6 +727,15 @@ class hopscotch_map {
   void rehash(size_type count_) { m_ht.rehash(count_); }
   void reserve(size_type count_) { m_ht.reserve(count_); }
 
+  /**
+   * Threads used by rehash and bulk_load on large maps, 1 by default. The
+   * hash function is then called from several threads at once.
+   */
+  void set_build_threads(std::size_t threads) {
+    m_ht.set_build_threads(threads);
+  }
+  std::size_t build_threads() const { return m_ht.build_threads(); }
+
   /*
    * Observers
    */
@@ -692,6 +755,35 @@ class hopscotch_map {
 
   size_type overflow_size() const noexcept { return m_ht.overflow_size(); }
 
+  /**
+   * The container holding the overflown elements, e.g. to read the
+   * statistics of tsl::hh::vector_overflow or tsl::hh::indexed_overflow.
+   */
+  const overflow_container_type& overflow_container() const noexcept {
+    return m_ht.overflow_container();
+  }
+
+  /**
+   * Load factor, home-to-slot distances, neighborhood occupancy and insertion
+   * counters (displacements, rehashes), see tsl::hh::hopscotch_statistics.
+   * Linear in bucket_count().
+   */
+  tsl::hh::hopscotch_statistics statistics() const { return m_ht.statistics(); }
+
+  /**
+   * Visit the raw bucket array and the overflow elements, e.g. to serialize
+   * the table layout. See hopscotch_hash::visit_buckets.
+   */
+  template <class Visitor>
+  void visit_buckets(Visitor&& visitor) const {
+    m_ht.visit_buckets(std::forward<Visitor>(visitor));
+  }
+
+  template <class Visitor>
+  void visit_overflow(Visitor&& visitor) const {
+    m_ht.visit_overflow(std::forward<Visitor>(visitor));
+  }
+
   friend bool operator==(const hopscotch_map& lhs, const hopscotch_map& rhs) {
     if (lhs.size() != rhs.size()) {
       return false;
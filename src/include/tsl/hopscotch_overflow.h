@@ -0,0 +1,386 @@
+#ifndef TSL_HOPSCOTCH_OVERFLOW_H
+#define TSL_HOPSCOTCH_OVERFLOW_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Flat overflow containers for tsl::hopscotch_map and tsl::hopscotch_set.
+ *
+ * By default an element that finds no room in its neighborhood goes to a
+ * std::list, one allocation per element, and a lookup whose home bucket has
+ * the overflow flag walks the whole list comparing keys. With clustered keys
+ * or a weak hash the list grows and every lookup to an overflowing bucket
+ * pays a pointer chase per element.
+ *
+ * The containers below keep the overflown elements contiguous in a vector,
+ * together with the full hash of each element (hopscotch_hash hands it over
+ * on insert and lookup):
+ *  - vector_overflow scans the hashes, which act as fingerprints, and only
+ *    compares the keys of the elements whose hash matches.
+ *  - indexed_overflow adds an open-addressing index over the hashes, so a
+ *    lookup examines the few elements of one probe sequence whatever the
+ *    size of the overflow.
+ *
+ * Both keep statistics on how often the overflow is reached. Erasing is
+ * linear in the number of overflown elements, as it already is for the list
+ * (hopscotch_hash rescans the overflow to update the overflow flag).
+ * Contrary to the list, inserting in or erasing from the overflow
+ * invalidates the iterators on overflown elements: the vector may reallocate
+ * on insert, and it shifts the elements that follow an erased one.
+ * ValueType must be move-assignable.
+ */
+namespace tsl {
+namespace hh {
+
+/**
+ * Counters of an overflow container since its construction.
+ */
+struct overflow_statistics {
+  /**
+   * Lookups that reached the overflow container.
+   */
+  std::size_t lookups;
+  /**
+   * Lookups that found their key in it.
+   */
+  std::size_t hits;
+  /**
+   * Stored hashes examined by the lookups.
+   */
+  std::size_t scanned;
+  /**
+   * Keys compared, the stored hash having matched.
+   */
+  std::size_t compared;
+};
+
+template <class ValueType, class Allocator, bool Indexed>
+class hashed_overflow {
+ public:
+  /**
+   * Makes hopscotch_hash pass the hash of the key to emplace_hashed and find.
+   */
+  using hashed_overflow_tag = void;
+
+  using value_type = ValueType;
+  using allocator_type = Allocator;
+  using size_type = std::size_t;
+
+ private:
+  using values_container_type = std::vector<ValueType, Allocator>;
+  using hashes_container_type = std::vector<
+      std::size_t, typename std::allocator_traits<
+                       Allocator>::template rebind_alloc<std::size_t>>;
+  using index_container_type = std::vector<
+      std::uint32_t, typename std::allocator_traits<
+                         Allocator>::template rebind_alloc<std::uint32_t>>;
+
+ public:
+  using iterator = typename values_container_type::iterator;
+  using const_iterator = typename values_container_type::const_iterator;
+
+  explicit hashed_overflow(const Allocator& alloc = Allocator())
+      : m_values(alloc), m_hashes(alloc), m_index(alloc), m_index_shift(0) {}
+
+  hashed_overflow(const hashed_overflow& other)
+      : m_values(other.m_values),
+        m_hashes(other.m_hashes),
+        m_index(other.m_index),
+        m_index_shift(other.m_index_shift),
+        m_counters(other.m_counters) {}
+
+  hashed_overflow(hashed_overflow&& other) noexcept
+      : m_values(std::move(other.m_values)),
+        m_hashes(std::move(other.m_hashes)),
+        m_index(std::move(other.m_index)),
+        m_index_shift(other.m_index_shift),
+        m_counters(other.m_counters) {
+    other.clear();
+  }
+
+  hashed_overflow& operator=(const hashed_overflow& other) {
+    if (&other != this) {
+      m_values = other.m_values;
+      m_hashes = other.m_hashes;
+      m_index = other.m_index;
+      m_index_shift = other.m_index_shift;
+      m_counters = other.m_counters;
+    }
+    return *this;
+  }
+
+  hashed_overflow& operator=(hashed_overflow&& other) noexcept {
+    if (&other != this) {
+      m_values = std::move(other.m_values);
+      m_hashes = std::move(other.m_hashes);
+      m_index = std::move(other.m_index);
+      m_index_shift = other.m_index_shift;
+      m_counters = other.m_counters;
+      other.clear();
+    }
+    return *this;
+  }
+
+  iterator begin() noexcept { return m_values.begin(); }
+  const_iterator begin() const noexcept { return m_values.begin(); }
+  const_iterator cbegin() const noexcept { return m_values.cbegin(); }
+
+  iterator end() noexcept { return m_values.end(); }
+  const_iterator end() const noexcept { return m_values.end(); }
+  const_iterator cend() const noexcept { return m_values.cend(); }
+
+  size_type size() const noexcept { return m_values.size(); }
+  bool empty() const noexcept { return m_values.empty(); }
+
+  void clear() noexcept {
+    m_values.clear();
+    m_hashes.clear();
+    m_index.clear();
+    m_index_shift = 0;
+  }
+
+  /**
+   * The statistics follow the elements, hopscotch_hash swaps the overflow
+   * into the new table on rehash.
+   */
+  void swap(hashed_overflow& other) noexcept {
+    using std::swap;
+    m_values.swap(other.m_values);
+    m_hashes.swap(other.m_hashes);
+    m_index.swap(other.m_index);
+    swap(m_index_shift, other.m_index_shift);
+    m_counters.swap(other.m_counters);
+  }
+
+  /**
+   * Add an element, hash being the hash of its key.
+   */
+  template <class... Args>
+  iterator emplace_hashed(std::size_t hash, Args&&... value_type_args) {
+    m_values.emplace_back(std::forward<Args>(value_type_args)...);
+#ifndef TSL_HH_NO_EXCEPTIONS
+    try {
+#endif
+      m_hashes.push_back(hash);
+      if (Indexed) {
+        if (2 * m_values.size() > m_index.size()) {
+          rebuild_index();
+        } else {
+          index_insert(m_values.size() - 1);
+        }
+      }
+#ifndef TSL_HH_NO_EXCEPTIONS
+    } catch (...) {
+      m_values.pop_back();
+      m_hashes.resize(m_values.size());
+      throw;
+    }
+#endif
+    return std::prev(m_values.end());
+  }
+
+  /**
+   * Return an iterator on the element with the given key hash for which
+   * equal(element) is true, end() if there is none.
+   */
+  template <class Predicate>
+  iterator find(std::size_t hash, Predicate&& equal) {
+    return m_values.begin() +
+           std::ptrdiff_t(find_position(hash, std::forward<Predicate>(equal)));
+  }
+
+  template <class Predicate>
+  const_iterator find(std::size_t hash, Predicate&& equal) const {
+    return m_values.cbegin() +
+           std::ptrdiff_t(find_position(hash, std::forward<Predicate>(equal)));
+  }
+
+  iterator erase(const_iterator pos) { return erase(pos, std::next(pos)); }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    const std::ptrdiff_t offset = first - m_values.cbegin();
+    const std::ptrdiff_t count = last - first;
+    if (count == 0) {
+      return m_values.begin() + offset;
+    }
+
+    auto it_next = m_values.erase(first, last);
+    m_hashes.erase(m_hashes.begin() + offset,
+                   m_hashes.begin() + offset + count);
+    if (Indexed) {
+      rebuild_index();
+    }
+    return it_next;
+  }
+
+  overflow_statistics statistics() const noexcept {
+    return m_counters.load();
+  }
+
+  /**
+   * Bytes used for the hashes and the index, on top of the elements.
+   */
+  size_type metadata_bytes() const noexcept {
+    return m_hashes.capacity() * sizeof(std::size_t) +
+           m_index.capacity() * sizeof(std::uint32_t);
+  }
+
+ private:
+  static constexpr std::uint32_t EMPTY_SLOT = ~std::uint32_t(0);
+  static constexpr std::size_t MIN_INDEX_SIZE = 16;
+
+  /**
+   * Relaxed atomics: lookups are const and may run concurrently.
+   */
+  class counters {
+   public:
+    counters() noexcept : m_lookups(0), m_hits(0), m_scanned(0), m_compared(0) {}
+
+    counters(const counters& other) noexcept { store(other.load()); }
+
+    counters& operator=(const counters& other) noexcept {
+      store(other.load());
+      return *this;
+    }
+
+    void swap(counters& other) noexcept {
+      const overflow_statistics mine = load();
+      store(other.load());
+      other.store(mine);
+    }
+
+    void record(std::size_t scanned, std::size_t compared,
+                bool hit) const noexcept {
+      m_lookups.fetch_add(1, std::memory_order_relaxed);
+      m_scanned.fetch_add(scanned, std::memory_order_relaxed);
+      m_compared.fetch_add(compared, std::memory_order_relaxed);
+      if (hit) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    overflow_statistics load() const noexcept {
+      return overflow_statistics{m_lookups.load(std::memory_order_relaxed),
+                                 m_hits.load(std::memory_order_relaxed),
+                                 m_scanned.load(std::memory_order_relaxed),
+                                 m_compared.load(std::memory_order_relaxed)};
+    }
+
+   private:
+    void store(const overflow_statistics& statistics) noexcept {
+      m_lookups.store(statistics.lookups, std::memory_order_relaxed);
+      m_hits.store(statistics.hits, std::memory_order_relaxed);
+      m_scanned.store(statistics.scanned, std::memory_order_relaxed);
+      m_compared.store(statistics.compared, std::memory_order_relaxed);
+    }
+
+    mutable std::atomic<std::size_t> m_lookups;
+    mutable std::atomic<std::size_t> m_hits;
+    mutable std::atomic<std::size_t> m_scanned;
+    mutable std::atomic<std::size_t> m_compared;
+  };
+
+  /**
+   * Elements overflow together because their hashes share the low bits
+   * selecting the home bucket, the index slot is taken from the high bits of
+   * a Fibonacci multiplication instead.
+   */
+  std::size_t index_slot(std::size_t hash) const noexcept {
+    return std::size_t((std::uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >>
+                       m_index_shift);
+  }
+
+  template <class Predicate>
+  std::size_t find_position(std::size_t hash, Predicate&& equal) const {
+    std::size_t scanned = 0;
+    std::size_t compared = 0;
+    std::size_t position = m_values.size();
+    if (Indexed) {
+      if (!m_index.empty()) {
+        const std::size_t mask = m_index.size() - 1;
+        for (std::size_t slot = index_slot(hash); m_index[slot] != EMPTY_SLOT;
+             slot = (slot + 1) & mask) {
+          const std::size_t candidate = m_index[slot];
+          scanned++;
+          if (m_hashes[candidate] == hash) {
+            compared++;
+            if (equal(m_values[candidate])) {
+              position = candidate;
+              break;
+            }
+          }
+        }
+      }
+    } else {
+      for (std::size_t candidate = 0; candidate < m_hashes.size();
+           candidate++) {
+        scanned++;
+        if (m_hashes[candidate] == hash) {
+          compared++;
+          if (equal(m_values[candidate])) {
+            position = candidate;
+            break;
+          }
+        }
+      }
+    }
+    m_counters.record(scanned, compared, position != m_values.size());
+    return position;
+  }
+
+  void index_insert(std::size_t position) noexcept {
+    const std::size_t mask = m_index.size() - 1;
+    std::size_t slot = index_slot(m_hashes[position]);
+    while (m_index[slot] != EMPTY_SLOT) {
+      slot = (slot + 1) & mask;
+    }
+    m_index[slot] = std::uint32_t(position);
+  }
+
+  /**
+   * Size the index to a power of two at least twice the number of elements
+   * and insert every element again.
+   */
+  void rebuild_index() {
+    if (m_values.empty()) {
+      m_index.clear();
+      m_index_shift = 0;
+      return;
+    }
+
+    std::size_t index_size = MIN_INDEX_SIZE;
+    unsigned int bits = 4;
+    while (index_size < 2 * m_values.size()) {
+      index_size *= 2;
+      bits++;
+    }
+    m_index.assign(index_size, EMPTY_SLOT);
+    m_index_shift = 64 - bits;
+    for (std::size_t position = 0; position < m_values.size(); position++) {
+      index_insert(position);
+    }
+  }
+
+  values_container_type m_values;
+  hashes_container_type m_hashes;
+  index_container_type m_index;
+  unsigned int m_index_shift;
+  counters m_counters;
+};
+
+template <class ValueType, class Allocator = std::allocator<ValueType>>
+using vector_overflow = hashed_overflow<ValueType, Allocator, false>;
+
+template <class ValueType, class Allocator = std::allocator<ValueType>>
+using indexed_overflow = hashed_overflow<ValueType, Allocator, true>;
+
+}  // end namespace hh
+}  // end namespace tsl
+
+#endif
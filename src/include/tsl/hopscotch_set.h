@@ -34,6 +34,7 @@
 #include <utility>
 
 #include "hopscotch_hash.h"
+#include "hopscotch_overflow.h"
 
 namespace tsl {
 
@@ -63,6 +64,18 @@ namespace tsl {
  * set the hash to a bucket instead of the slow modulo. You may define your own
  * growth policy, check tsl::power_of_two_growth_policy for the interface.
  *
+ * OverflowContainer stores the elements which do not fit in the neighborhood
+ * of their bucket. The default std::list is scanned linearly on lookup;
+ * tsl::hh::vector_overflow and tsl::hh::indexed_overflow keep them contiguous
+ * and search them by hash, see hopscotch_overflow.h.
+ *
+ * CompactBuckets, for a Key that is trivially copy constructible and trivially
+ * destructible, stores the neighborhood bitmap unaligned after the element so
+ * that a bucket is only aligned as the element, and makes the buckets
+ * trivially copyable: copies and rehashes move them with memcpy. It pays off
+ * with a NeighborhoodSize small enough for a narrow bitmap, e.g. 30 instead of
+ * 62 for a 4-byte Key.
+ *
  * If the destructor of Key throws an exception, behaviour of the class is
  * undefined.
  *
@@ -73,13 +86,17 @@ namespace tsl {
  * collision (which mean that most of the time, insert will invalidate the
  * iterators). Or if there is a rehash.
  *  - erase: iterator on the erased element is the only one which become
- * invalid.
+ * invalid. With tsl::hh::vector_overflow or tsl::hh::indexed_overflow as
+ * OverflowContainer, erasing an overflown element also invalidates the
+ * iterators on the other overflown elements.
  */
 template <class Key, class Hash = std::hash<Key>,
           class KeyEqual = std::equal_to<Key>,
           class Allocator = std::allocator<Key>,
           unsigned int NeighborhoodSize = 62, bool StoreHash = false,
-          class GrowthPolicy = tsl::hh::power_of_two_growth_policy<2>>
+          class GrowthPolicy = tsl::hh::power_of_two_growth_policy<2>,
+          class OverflowContainer = std::list<Key, Allocator>,
+          bool CompactBuckets = false>
 class hopscotch_set {
  private:
   template <typename U>
@@ -94,10 +111,10 @@ class hopscotch_set {
     key_type& operator()(Key& key) { return key; }
   };
 
-  using overflow_container_type = std::list<Key, Allocator>;
+  using overflow_container_type = OverflowContainer;
   using ht = detail_hopscotch_hash::hopscotch_hash<
       Key, KeySelect, void, Hash, KeyEqual, Allocator, NeighborhoodSize,
-      StoreHash, GrowthPolicy, overflow_container_type>;
+      StoreHash, GrowthPolicy, overflow_container_type, CompactBuckets>;
 
  public:
   using key_type = typename ht::key_type;
@@ -550,6 +567,21 @@ class hopscotch_set {
 
   size_type overflow_size() const noexcept { return m_ht.overflow_size(); }
 
+  /**
+   * The container holding the overflown elements, e.g. to read the
+   * statistics of tsl::hh::vector_overflow or tsl::hh::indexed_overflow.
+   */
+  const overflow_container_type& overflow_container() const noexcept {
+    return m_ht.overflow_container();
+  }
+
+  /**
+   * Load factor, home-to-slot distances, neighborhood occupancy and insertion
+   * counters (displacements, rehashes), see tsl::hh::hopscotch_statistics.
+   * Linear in bucket_count().
+   */
+  tsl::hh::hopscotch_statistics statistics() const { return m_ht.statistics(); }
+
   friend bool operator==(const hopscotch_set& lhs, const hopscotch_set& rhs) {
     if (lhs.size() != rhs.size()) {
       return false;
@@ -1,8 +1,14 @@
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 // #include <nlohmann/json.hpp>
 #include "include/nlohmann/json.hpp"
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <random>
+#include <cmath>
 #include "ContainerInterface.h"
 
 using json = nlohmann::json;
@@ -11,44 +17,588 @@ using namespace chrono;
 
 typedef std::chrono::high_resolution_clock Clock;
 
-void measureMap(json inputJson, json queryJson, ContainerInterface<int, int>& container)
+// Key/value arrays extracted once from the input and query JSON files
+struct Workload {
+    vector<int> keys;
+    vector<int> values;
+    vector<int> queries;
+    vector<int> expected;
+    // Keys absent from the input, one per query
+    vector<int> misses;
+};
+
+Workload loadWorkload(const json& inputJson, const json& queryJson)
+{
+    Workload workload;
+    for(size_t key=1; key < inputJson.size(); key++){
+        string str = to_string(key);
+        workload.keys.push_back(key);
+        workload.values.push_back(inputJson[str]);
+    }
+    for(size_t i=1; i < queryJson.size(); i++){
+        string str = to_string(i);
+        int key = queryJson[str];
+        workload.queries.push_back(key);
+        string str1 = to_string(key);
+        workload.expected.push_back(inputJson[str1]);
+    }
+    // Input keys are 1..N-1, shift the queries past them to get the same number of misses
+    const int missOffset = int(inputJson.size());
+    for (int key : workload.queries) {
+        workload.misses.push_back(key + missOffset);
+    }
+    return workload;
+}
+
+// Adversarial key set for hashes that keep the low bits (std::hash<int> is the
+// identity): count keys, all multiples of stride, so they share a few home
+// buckets and most of them overflow their neighborhood. Queries and misses
+// hit the same buckets.
+Workload clusteredWorkload(const Workload& workload, size_t count, int stride)
+{
+    Workload clustered;
+    count = min(count, workload.keys.size());
+    for(size_t i=0; i < count; i++){
+        clustered.keys.push_back(int(i + 1) * stride);
+        clustered.values.push_back(workload.values[i]);
+    }
+    for(size_t i=0; i < count && i < workload.queries.size(); i++){
+        const size_t index = size_t(workload.queries[i] - 1) % count;
+        clustered.queries.push_back(clustered.keys[index]);
+        clustered.expected.push_back(clustered.values[index]);
+        clustered.misses.push_back(int(count + index + 1) * stride);
+    }
+    return clustered;
+}
+
+// Written by measureHashQuality to keep the hashing from being optimized away
+volatile size_t hashSink;
+
+// Quality of one hash function on named key sets: hashing throughput, how
+// evenly the keys fall in the buckets of a power-of-two table, and for a
+// hopscotch table built with it the home-to-slot displacements and overflow
+template <class Hash>
+void measureHashQuality(const string& name, const vector<pair<string, vector<int>>>& keySets)
+{
+    typedef tsl::hopscotch_map<int, int, Hash> Table;
+    const Hash hash;
+    for (const auto& keySet : keySets) {
+        const vector<int>& keys = keySet.second;
+        const size_t ROUNDS = 16;
+        size_t sink = 0;
+        auto start = Clock::now();
+        for (size_t round = 0; round < ROUNDS; round++) {
+            for (int key : keys)
+                sink ^= hash(int(uint32_t(key) + uint32_t(round)));
+        }
+        const double hashNs = double(duration_cast<nanoseconds>(Clock::now() - start).count()) / (ROUNDS * keys.size());
+        hashSink = sink;
+
+        Table table;
+        for (size_t i = 0; i < keys.size(); i++)
+            table[keys[i]] = int(i);
+
+        // Keys per home bucket against the Poisson ideal of a uniform hash
+        const size_t buckets = table.bucket_count();
+        vector<uint32_t> perBucket(buckets, 0);
+        for (int key : keys)
+            perBucket[hash(key) & (buckets - 1)]++;
+        const size_t emptyBuckets = size_t(count(perBucket.begin(), perBucket.end(), 0u));
+        const uint32_t fullestBucket = *max_element(perBucket.begin(), perBucket.end());
+        const double load = double(keys.size()) / buckets;
+
+        // Distance in buckets of every element from its home bucket
+        const tsl::hh::hopscotch_statistics stats = table.statistics();
+        size_t totalDisplacement = 0, worstDisplacement = 0;
+        for (size_t distance = 0; distance < stats.distance_histogram.size(); distance++) {
+            totalDisplacement += distance * stats.distance_histogram[distance];
+            if (stats.distance_histogram[distance] != 0)
+                worstDisplacement = distance;
+        }
+
+        cout << "Hash " << name << " on " << keySet.first << " keys: " << hashNs << " ns/hash, empty buckets "
+             << 100.0 * emptyBuckets / buckets << "% (uniform " << 100.0 * exp(-load) << "%), fullest bucket "
+             << fullestBucket << " keys, displacement mean "
+             << (table.size() ? double(totalDisplacement) / (table.size() - table.overflow_size()) : 0.0)
+             << " max " << worstDisplacement << ", overflow " << table.overflow_size() << endl;
+    }
+}
+
+// Lookups, then range erase over a hopscotch table whose clustered keys fill
+// the overflow: the second half of the table, then what remains. Negative keys
+// spread over a table reserved large first only reach the overflow when
+// rehash(0) shrinks it, a StoreHash table then moves them with the truncated
+// hash it kept of their sign-extended hash.
+template <class Overflow, bool StoreHash = false>
+void checkRangeErase(const Workload& clustered, const string& name)
+{
+    tsl::hopscotch_map<int, int, std::hash<int>, std::equal_to<int>, std::allocator<pair<int, int>>,
+                       StoreHash ? 30 : 62, StoreHash, tsl::hh::power_of_two_growth_policy<2>, Overflow> table;
+    table.rehash(size_t(1) << 19);
+    for (size_t i = 0; i < clustered.keys.size(); i++) {
+        table[clustered.keys[i]] = clustered.values[i];
+        table[-clustered.keys[i] / 64] = clustered.values[i];
+    }
+    table.rehash(0);
+    size_t incorrect = 0;
+    for (size_t i = 0; i < clustered.keys.size(); i++) {
+        const auto it = table.find(clustered.keys[i]);
+        const auto spread = table.find(-clustered.keys[i] / 64);
+        if (it == table.end() || it->second != clustered.values[i] || spread == table.end() ||
+            spread->second != clustered.values[i])
+            incorrect++;
+    }
+    if (incorrect > 0)
+        cout << "the overflow lookup is incorrect (" << name << "): " << incorrect << " keys not found" << endl;
+    const size_t overflow = table.overflow_size();
+    auto middle = table.begin();
+    advance(middle, table.size() / 2);
+    const size_t kept = size_t(distance(table.begin(), middle));
+    const auto next = table.erase(middle, table.end());
+    if (next != table.end() || table.size() != kept)
+        cout << "the range erase is incorrect (" << name << "): " << table.size() << " != " << kept << endl;
+    table.erase(table.begin(), table.end());
+    if (!table.empty() || table.overflow_size() != 0)
+        cout << "the full range erase is incorrect (" << name << "): " << table.size() << " left" << endl;
+    cout << "Range erase (" << name << "): " << 2 * clustered.keys.size() << " keys, " << overflow << " overflown"
+         << endl;
+}
+
+void measureMap(const Workload& workload, ContainerInterface<int, int>& container)
 {
     cout << "container <<<<<" << container.getString() << ">>>>>>>>>>>>\n";
     // Measure Insert Time
-    auto totalInsertTime = std::chrono::nanoseconds::zero();
     auto start = Clock::now();
-    // Read from JSON structure and load the container
-    for(size_t key=1; key < inputJson.size(); key++){
-        string str = to_string(key); 
-        int value = inputJson[str];
-        // Insert into the plain container
-        totalInsertTime += container.insert(key, value);
-    }
+    // Load the container from the workload arrays
+    auto totalInsertTime = container.bulkLoad(workload.keys, workload.values);
     auto stop = Clock::now();
     auto timeTakenToLoadTheMap = duration_cast<seconds>(stop - start);
     cout << "Time taken to load the container: " << timeTakenToLoadTheMap.count() << " seconds \n";
     cout << "Total insert time: " << totalInsertTime.count() << " nanoseconds, " << std::chrono::duration<double>(totalInsertTime).count() << " seconds" << endl;
+    container.printLoadStats();
 
     // Measure Probing Time
     auto totalLookupTime = std::chrono::nanoseconds::zero();
     auto lookupStart = Clock::now();
-    for(size_t i=1; i < queryJson.size(); i++){
-        string str = to_string(i);
+    for(size_t i=0; i < workload.queries.size(); i++){
         int val;
-        int key = queryJson[str];
-        totalLookupTime += container.probeKey(key, val);
+        totalLookupTime += container.probeKey(workload.queries[i], val);
         //verify value
-        string str1 = to_string(key);
-        int value = inputJson[str1];
-        if (val != value)
+        if (val != workload.expected[i])
         {
-            cout << "the value is incorrect: " << val << " != " << value << endl;
-        }   
+            cout << "the value is incorrect: " << val << " != " << workload.expected[i] << endl;
+        }
     }
     auto lookupStop = Clock::now();
     auto timeTakenToLookupTheMap = duration_cast<seconds>(lookupStop - lookupStart);
     cout << "Time taken to lookup the container = " << timeTakenToLookupTheMap.count() << " seconds \n";
     cout << "Total lookup time: " << totalLookupTime.count() << " nanoseconds, " << std::chrono::duration<double>(totalLookupTime).count() << " seconds" << endl;
+
+    // Measure batched probing: the container may overlap independent lookups
+    const size_t batchSize = 64;
+    vector<int> batchValues(batchSize);
+    unique_ptr<bool[]> batchFound(new bool[batchSize]);
+    auto totalBatchTime = std::chrono::nanoseconds::zero();
+    for (size_t first = 0; first < workload.queries.size(); first += batchSize) {
+        const size_t n = min(batchSize, workload.queries.size() - first);
+        totalBatchTime += container.probeBatch(&workload.queries[first], n, batchValues.data(), batchFound.get());
+        for (size_t i = 0; i < n; i++) {
+            if (!batchFound[i] || batchValues[i] != workload.expected[first + i])
+                cout << "the batched value is incorrect: " << batchValues[i] << " != " << workload.expected[first + i] << endl;
+        }
+    }
+    cout << "Total batched lookup time (" << batchSize << " keys per batch): " << totalBatchTime.count() << " nanoseconds, " << std::chrono::duration<double>(totalBatchTime).count() << " seconds" << endl;
+
+    // Measure negative lookups: none of the keys is in the container
+    size_t falseHits = 0;
+    auto missStart = Clock::now();
+    for (int key : workload.misses) {
+        if (container.contains(key))
+            falseHits++;
+    }
+    auto missStop = Clock::now();
+    auto totalMissTime = duration_cast<nanoseconds>(missStop - missStart);
+    cout << "Total miss lookup time: " << totalMissTime.count() << " nanoseconds, "
+         << (workload.misses.empty() ? 0.0 : double(totalMissTime.count()) / workload.misses.size()) << " ns/miss";
+    if (falseHits)
+        cout << ", reported present: " << falseHits;
+    cout << endl;
+    container.printStats();
+}
+
+// Shared-table workload for thread-safe containers: the first half of the keys
+// is loaded up front, then writer threads insert the second half while reader
+// threads look up the queries that hit the first half
+void measureConcurrentMap(const Workload& workload, ContainerInterface<int, int>& container,
+                          unsigned readers, unsigned writers)
+{
+    const size_t preloaded = writers ? workload.keys.size() / 2 : workload.keys.size();
+    vector<int> preloadKeys(workload.keys.begin(), workload.keys.begin() + preloaded);
+    vector<int> preloadValues(workload.values.begin(), workload.values.begin() + preloaded);
+    container.bulkLoad(preloadKeys, preloadValues);
+
+    // Workload keys are ascending, so the preloaded ones are <= the last preloaded key
+    vector<size_t> stableQueries;
+    for(size_t i=0; i < workload.queries.size(); i++){
+        if (preloaded && workload.queries[i] <= workload.keys[preloaded - 1])
+            stableQueries.push_back(i);
+    }
+
+    atomic<unsigned> writersRunning(writers);
+    atomic<size_t> lookups(0), incorrect(0);
+    vector<thread> threads;
+    auto start = Clock::now();
+    for (unsigned w = 0; w < writers; w++) {
+        threads.emplace_back([&, w]() {
+            for (size_t i = preloaded + w; i < workload.keys.size(); i += writers)
+                container.insert(workload.keys[i], workload.values[i]);
+            writersRunning--;
+        });
+    }
+    Clock::time_point writersStop = start;
+    thread writerWatch([&]() {
+        for (auto& t : threads)
+            t.join();
+        writersStop = Clock::now();
+    });
+    vector<thread> readerThreads;
+    for (unsigned r = 0; r < readers; r++) {
+        readerThreads.emplace_back([&, r]() {
+            size_t done = 0, wrong = 0;
+            // At least one full pass, then keep reading while writers run
+            size_t i = r * stableQueries.size() / readers;
+            for (size_t n = 0; n < stableQueries.size() || writersRunning > 0; n++, i++) {
+                if (i == stableQueries.size())
+                    i = 0;
+                if (stableQueries.empty())
+                    break;
+                int val;
+                container.probeKey(workload.queries[stableQueries[i]], val);
+                if (val != workload.expected[stableQueries[i]])
+                    wrong++;
+                done++;
+            }
+            lookups += done;
+            incorrect += wrong;
+        });
+    }
+    for (auto& t : readerThreads)
+        t.join();
+    auto readersStop = Clock::now();
+    writerWatch.join();
+
+    const double writeSeconds = std::chrono::duration<double>(writersStop - start).count();
+    const double readSeconds = std::chrono::duration<double>(readersStop - start).count();
+    const size_t inserts = workload.keys.size() - preloaded;
+    cout << "Concurrent " << container.getString() << ", " << readers << " readers, " << writers << " writers: "
+         << inserts << " inserts in " << writeSeconds << " seconds ("
+         << (writeSeconds > 0 ? inserts / writeSeconds / 1e6 : 0.0) << " Mops/s), " << lookups << " lookups in "
+         << readSeconds << " seconds (" << (readSeconds > 0 ? lookups / readSeconds / 1e6 : 0.0) << " Mops/s)";
+    if (incorrect > 0)
+        cout << ", " << incorrect << " incorrect values";
+    cout << endl;
+
+    // Every key must be visible once all writers are done
+    for(size_t i=0; i < workload.queries.size(); i++){
+        int val;
+        container.probeKey(workload.queries[i], val);
+        if (val != workload.expected[i])
+            cout << "the value is incorrect: " << val << " != " << workload.expected[i] << endl;
+    }
+    container.printStats();
+}
+
+// Throughput of a thread-safe container from 1 to all hardware threads: the
+// threads first insert disjoint slices of the keys into an empty container,
+// then each runs the whole query list
+vector<unsigned> scalingThreadCounts()
+{
+    const unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+    return threadCounts;
+}
+
+template <class SharedContainer>
+void measureScalability(const Workload& workload)
+{
+    for (unsigned threads : scalingThreadCounts()) {
+        SharedContainer container;
+        vector<thread> workers;
+        auto start = Clock::now();
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                for (size_t i = t; i < workload.keys.size(); i += threads)
+                    container.insert(workload.keys[i], workload.values[i]);
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+        const double insertSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        workers.clear();
+        atomic<size_t> incorrect(0);
+        start = Clock::now();
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                size_t wrong = 0;
+                const size_t offset = t * workload.queries.size() / threads;
+                for (size_t n = 0; n < workload.queries.size(); n++) {
+                    const size_t i = (offset + n) % workload.queries.size();
+                    int val;
+                    container.probeKey(workload.queries[i], val);
+                    if (val != workload.expected[i])
+                        wrong++;
+                }
+                incorrect += wrong;
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+        const double lookupSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        cout << "Scaling " << container.getString() << ", " << threads << " threads: "
+             << workload.keys.size() / insertSeconds / 1e6 << " Minserts/s, "
+             << double(threads) * workload.queries.size() / lookupSeconds / 1e6 << " Mlookups/s";
+        if (incorrect > 0)
+            cout << ", " << incorrect << " incorrect values";
+        cout << endl;
+    }
+}
+
+// Hopscotch table built by bulk_load and grown by a rehash, each with 1 to all
+// hardware threads filling bucket ranges in parallel
+void measureBulkBuild(const Workload& workload)
+{
+    for (unsigned threads : scalingThreadCounts()) {
+        tsl::hopscotch_map<int, int> map;
+        map.set_build_threads(threads);
+        auto start = Clock::now();
+        map.bulk_load(workload.keys.data(), workload.values.data(), workload.keys.size());
+        const double buildSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        start = Clock::now();
+        map.rehash(map.bucket_count() * 2);
+        const double rehashSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        size_t incorrect = 0;
+        for (size_t i = 0; i < workload.queries.size(); i++) {
+            auto it = map.find(workload.queries[i]);
+            if (it == map.end() || it->second != workload.expected[i])
+                incorrect++;
+        }
+        cout << "Bulk build HopscotchMap, " << threads << " threads: "
+             << workload.keys.size() / buildSeconds / 1e6 << " Minserts/s, rehash to " << map.bucket_count()
+             << " buckets: " << rehashSeconds * 1e3 << " ms, overflow: " << map.overflow_size();
+        if (incorrect > 0)
+            cout << ", " << incorrect << " incorrect values";
+        cout << endl;
+    }
+}
+
+// std::hash that throws once, on the call where the shared countdown reaches zero
+struct ThrowingHash {
+    shared_ptr<atomic<long>> countdown = make_shared<atomic<long>>(-1);
+
+    size_t operator()(int key) const {
+        if (countdown->fetch_sub(1) == 0)
+            throw runtime_error("hash failure");
+        return std::hash<int>()(key);
+    }
+};
+
+// A rehash with several build threads whose hash fails at points spread over
+// its phases must leave the table as it was
+void checkRehashRollback(const Workload& workload)
+{
+    typedef tsl::hopscotch_map<int, int, ThrowingHash> Table;
+    const long NO_FAILURE = 1L << 40;
+    long hashCalls = 0;
+    size_t rolledBack = 0;
+    for (int point = -1; point < 4; point++) {
+        ThrowingHash hash;
+        Table table(0, hash);
+        table.set_build_threads(4);
+        for (size_t i = 0; i < workload.keys.size(); i++)
+            table[workload.keys[i]] = workload.values[i];
+        const size_t bucketCount = table.bucket_count();
+
+        // Point -1 runs without failure and counts the hash calls of a rehash
+        *hash.countdown = point < 0 ? NO_FAILURE : hashCalls * point / 4 + (point == 0 ? 0 : 1);
+        bool thrown = false;
+        try {
+            table.rehash(bucketCount * 2);
+        } catch (const runtime_error&) {
+            thrown = true;
+        }
+        if (point < 0)
+            hashCalls = NO_FAILURE - hash.countdown->load();
+        *hash.countdown = -1;
+
+        size_t incorrect = 0;
+        for (size_t i = 0; i < workload.queries.size(); i++) {
+            auto it = table.find(workload.queries[i]);
+            if (it == table.end() || it->second != workload.expected[i])
+                incorrect++;
+        }
+        // Iteration skips empty buckets: a lost element shows even if its stale bits still find it
+        const size_t iterated = size_t(distance(table.begin(), table.end()));
+        if (thrown != (point >= 0) || table.size() != workload.keys.size() || iterated != table.size() ||
+            incorrect > 0 || (thrown && table.bucket_count() != bucketCount))
+            cout << "the rehash rollback is incorrect: " << table.size() << " elements, " << iterated
+                 << " iterated, " << incorrect << " wrong values" << endl;
+        rolledBack += thrown;
+    }
+    cout << "Rehash rollback: " << hashCalls << " hash calls per rehash, " << rolledBack << " failures rolled back"
+         << endl;
+}
+
+// Read-mostly workload: reader threads (1 to all hardware threads) run the
+// query list while one writer rewrites a batch of existing keys every
+// millisecond, which keeps lookup results verifiable
+template <class SharedContainer>
+void measureReadMostly(const Workload& workload, size_t batchSize = 1024)
+{
+    for (unsigned threads : scalingThreadCounts()) {
+        SharedContainer container;
+        container.bulkLoad(workload.keys, workload.values);
+
+        atomic<bool> readersDone(false);
+        size_t batches = 0;
+        thread writer([&]() {
+            for (size_t offset = 0; !readersDone; offset += batchSize) {
+                vector<int> batchKeys, batchValues;
+                for (size_t i = 0; i < batchSize; i++) {
+                    const size_t index = (offset + i) % workload.keys.size();
+                    batchKeys.push_back(workload.keys[index]);
+                    batchValues.push_back(workload.values[index]);
+                }
+                container.bulkLoad(batchKeys, batchValues);
+                batches++;
+                this_thread::sleep_for(milliseconds(1));
+            }
+        });
+
+        vector<thread> readers;
+        atomic<size_t> incorrect(0);
+        auto start = Clock::now();
+        for (unsigned t = 0; t < threads; t++) {
+            readers.emplace_back([&, t]() {
+                size_t wrong = 0;
+                const size_t offset = t * workload.queries.size() / threads;
+                for (size_t n = 0; n < workload.queries.size(); n++) {
+                    const size_t i = (offset + n) % workload.queries.size();
+                    int val;
+                    container.probeKey(workload.queries[i], val);
+                    if (val != workload.expected[i])
+                        wrong++;
+                }
+                incorrect += wrong;
+            });
+        }
+        for (auto& reader : readers)
+            reader.join();
+        const double lookupSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+        readersDone = true;
+        writer.join();
+
+        cout << "Read-mostly " << container.getString() << ", " << threads << " readers: "
+             << double(threads) * workload.queries.size() / lookupSeconds / 1e6 << " Mlookups/s, "
+             << batches << " update batches of " << batchSize << " keys";
+        if (incorrect > 0)
+            cout << ", " << incorrect << " incorrect values";
+        cout << endl;
+    }
+}
+
+// Shared-nothing alternative to the shared tables: client threads send their
+// lookups in batches to shard threads owning private partitions
+void measureShardedMap(const Workload& workload, size_t shards, size_t clients, size_t batchSize)
+{
+    ShardedMap<int, int> container(shards, clients);
+    container.insertBatch(0, workload.keys.data(), workload.values.data(), workload.keys.size());
+    container.flush(0);
+
+    vector<thread> workers;
+    atomic<size_t> incorrect(0);
+    auto start = Clock::now();
+    for (size_t c = 0; c < clients; c++) {
+        workers.emplace_back([&, c]() {
+            vector<int> keys(batchSize), values(batchSize), expected(batchSize);
+            unique_ptr<bool[]> found(new bool[batchSize]);
+            size_t wrong = 0;
+            const size_t offset = c * workload.queries.size() / clients;
+            for (size_t n = 0; n < workload.queries.size(); n += batchSize) {
+                const size_t count = min(batchSize, workload.queries.size() - n);
+                for (size_t j = 0; j < count; j++) {
+                    const size_t i = (offset + n + j) % workload.queries.size();
+                    keys[j] = workload.queries[i];
+                    expected[j] = workload.expected[i];
+                }
+                container.findBatch(c, keys.data(), count, values.data(), found.get());
+                for (size_t j = 0; j < count; j++) {
+                    if (!found[j] || values[j] != expected[j])
+                        wrong++;
+                }
+            }
+            incorrect += wrong;
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    const double lookupSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    cout << "Sharded map, " << shards << " shards, " << clients << " clients, batches of " << batchSize << ": "
+         << double(clients) * workload.queries.size() / lookupSeconds / 1e6 << " Mlookups/s";
+    if (incorrect > 0)
+        cout << ", " << incorrect << " incorrect values";
+    cout << endl;
+}
+
+// Scan rangeLength consecutive keys starting at every query key of an ordered container
+template <class OrderedContainer>
+void measureRangeScan(const Workload& workload, const OrderedContainer& container, int rangeLength)
+{
+    size_t visited = 0;
+    long long checksum = 0;
+    auto start = Clock::now();
+    for(size_t i=0; i < workload.queries.size(); i++){
+        int lo = workload.queries[i];
+        visited += container.rangeScan(lo, lo + rangeLength - 1, [&](const int&, const int& value) {
+            checksum += value;
+        });
+    }
+    auto stop = Clock::now();
+    auto elapsed = duration_cast<nanoseconds>(stop - start);
+    cout << "Range scan (" << rangeLength << " keys) over " << container.getString() << ": " << elapsed.count()
+         << " nanoseconds, " << visited << " pairs visited, "
+         << (visited ? double(elapsed.count()) / visited : 0.0) << " ns/pair (checksum " << checksum << ")" << endl;
+}
+
+// Interleaved lookups of every query with group lookups in flight: a group of
+// 1 is the cost of the coroutines alone, larger groups overlap cache misses
+template <class Map>
+void measureInterleaving(const Workload& workload, const string& name)
+{
+    Map map;
+    for(size_t i=0; i < workload.keys.size(); i++){
+        map[workload.keys[i]] = workload.values[i];
+    }
+    vector<const int*> results(workload.queries.size());
+    for (size_t group : {1, 4, 8, 16, 32}) {
+        auto start = Clock::now();
+        interleavedFindBatch(map, workload.queries.data(), workload.queries.size(), results.data(), group);
+        auto stop = Clock::now();
+        for(size_t i=0; i < results.size(); i++){
+            if (results[i] == nullptr || *results[i] != workload.expected[i])
+                cout << "the interleaved value is incorrect for key " << workload.queries[i] << endl;
+        }
+        auto elapsed = duration_cast<nanoseconds>(stop - start);
+        cout << "Interleaved lookups over " << name << " (" << group << " in flight): " << elapsed.count()
+             << " nanoseconds, " << double(elapsed.count()) / results.size() << " ns/lookup" << endl;
+    }
 }
 
 int main(int argc, char** argv) {
@@ -69,12 +619,171 @@ int main(int argc, char** argv) {
     //read query file
     queryFile >> queryJson;
     queryFile.close();
+    Workload workload = loadWorkload(inputJson, queryJson);
     //compare insert and probing timing of different containers
     HopscotchMapContainer<int, int> hopSchotchMap;
-    measureMap(inputJson, queryJson, hopSchotchMap);
+    measureMap(workload, hopSchotchMap);
+    //stored hashes compared before keys, with AVX2 eight neighbors at a time
+    HopscotchMapContainer<int, int, std::allocator<pair<int, int>>, true> storedHashHopscotch;
+    measureMap(workload, storedHashHopscotch);
+    //12-byte buckets, the bitmap packed behind the pair, against the 16-byte default
+    {
+        typedef std::allocator<pair<int, int>> Allocator;
+        HopscotchMapContainer<int, int, Allocator, false, std::list<pair<int, int>>, std::hash<int>,
+                              tsl::hh::power_of_two_growth_policy<2>, true> compactHopscotch;
+        measureMap(workload, compactHopscotch);
+    }
+    //bucket counts grown by 5/4 with a multiply-high reduction, against doubling and against a modulo
+    {
+        typedef std::allocator<pair<int, int>> Allocator;
+        typedef std::list<pair<int, int>> Overflow;
+        HopscotchMapContainer<int, int, Allocator, false, Overflow, Fmix64Hash<int>> mixedHopscotch;
+        measureMap(workload, mixedHopscotch);
+        HopscotchMapContainer<int, int, Allocator, false, Overflow, Fmix64Hash<int>,
+                              tsl::hh::fastrange_growth_policy<>> fastrangeHopscotch;
+        measureMap(workload, fastrangeHopscotch);
+        HopscotchMapContainer<int, int, Allocator, false, Overflow, Fmix64Hash<int>,
+                              tsl::hh::mod_growth_policy<ratio<5, 4>>> moduloHopscotch;
+        measureMap(workload, moduloHopscotch);
+    }
+    //same table resized incrementally, compare the worst insert
+    IncrementalHopscotchContainer<int, int> incrementalHopscotch;
+    measureMap(workload, incrementalHopscotch);
+    //clustered keys overflowing their neighborhoods: overflow list against flat overflow storage
+    {
+        const Workload clustered = clusteredWorkload(workload, 5000, 1 << 16);
+        HopscotchMapContainer<int, int> clusteredHopscotch;
+        measureMap(clustered, clusteredHopscotch);
+        HopscotchMapContainer<int, int, std::allocator<pair<int, int>>, false, tsl::hh::vector_overflow<pair<int, int>>>
+            clusteredVectorOverflow;
+        measureMap(clustered, clusteredVectorOverflow);
+        HopscotchMapContainer<int, int, std::allocator<pair<int, int>>, false, tsl::hh::indexed_overflow<pair<int, int>>>
+            clusteredIndexedOverflow;
+        measureMap(clustered, clusteredIndexedOverflow);
+        //same keys with a mixing hash instead of the identity
+        HopscotchMapContainer<int, int, std::allocator<pair<int, int>>, false, std::list<pair<int, int>>,
+                              Fmix64Hash<int>> clusteredMixed;
+        measureMap(clustered, clusteredMixed);
+        checkRangeErase<std::list<pair<int, int>>>(clustered, "overflow list");
+        checkRangeErase<tsl::hh::vector_overflow<pair<int, int>>>(clustered, "vector overflow");
+        checkRangeErase<tsl::hh::indexed_overflow<pair<int, int>>>(clustered, "indexed overflow");
+        checkRangeErase<tsl::hh::vector_overflow<pair<int, int>>, true>(clustered, "vector overflow, stored hash");
+        checkRangeErase<tsl::hh::indexed_overflow<pair<int, int>>, true>(clustered, "indexed overflow, stored hash");
+    }
+    //hash functions on sequential, strided and random keys
+    {
+        mt19937 generator(42);
+        vector<int> randomKeys(workload.keys.size());
+        for (int& key : randomKeys)
+            key = int(generator());
+        const vector<pair<string, vector<int>>> keySets = {
+            {"sequential", workload.keys},
+            {"strided", clusteredWorkload(workload, 5000, 1 << 16).keys},
+            {"random", randomKeys}};
+        measureHashQuality<std::hash<int>>("std::hash", keySets);
+        measureHashQuality<MultiplyShiftHash<int>>(MultiplyShiftHash<int>::name(), keySets);
+        measureHashQuality<Fmix64Hash<int>>(Fmix64Hash<int>::name(), keySets);
+        measureHashQuality<WyHash<int>>(WyHash<int>::name(), keySets);
+        measureHashQuality<Crc32cHash<int>>(Crc32cHash<int>::name(), keySets);
+    }
     MapContainer<int, int> map;
-    measureMap(inputJson, queryJson, map);
+    measureMap(workload, map);
     UnorderedMapContainer<int, int> unorderedMap;
-    measureMap(inputJson, queryJson, unorderedMap);
+    measureMap(workload, unorderedMap);
+    //same node containers with nodes from a bump-pointer arena and from size-class pools instead of malloc
+    {
+        MapContainer<int, int, ArenaAllocator<pair<const int, int>>> arenaMap;
+        measureMap(workload, arenaMap);
+        MapContainer<int, int, PoolAllocator<pair<const int, int>>> poolMap;
+        measureMap(workload, poolMap);
+        UnorderedMapContainer<int, int, ArenaAllocator<pair<const int, int>>> arenaUnorderedMap;
+        measureMap(workload, arenaUnorderedMap);
+        UnorderedMapContainer<int, int, PoolAllocator<pair<const int, int>>> poolUnorderedMap;
+        measureMap(workload, poolUnorderedMap);
+    }
+    //same tables with bucket arrays on 2 MB pages, scoped to release them afterwards
+    {
+        HopscotchMapContainer<int, int, HugePageAllocator<pair<int, int>>> hugeHopscotch;
+        measureMap(workload, hugeHopscotch);
+        UnorderedMapContainer<int, int, HugePageAllocator<pair<const int, int>>> hugeUnorderedMap;
+        measureMap(workload, hugeUnorderedMap);
+    }
+    BPlusTreeContainer<int, int, 256> bPlusTree;
+    measureMap(workload, bPlusTree);
+    BPlusTreeContainer<int, int, 4096> pageBPlusTree;
+    measureMap(workload, pageBPlusTree);
+    ArtContainer<int, int> art;
+    measureMap(workload, art);
+    LearnedIndexContainer<int, int> learnedIndex;
+    measureMap(workload, learnedIndex);
+    MinimalPerfectHashContainer<int, int> perfectHash;
+    measureMap(workload, perfectHash);
+    //lower bound: perfect locality on a dense key domain
+    DirectMapContainer<int, int> directMap;
+    measureMap(workload, directMap);
+    //HashMem row layout on the CPU: row size and scan method
+    RowHashContainer<int, int> rowHash1K(1024);
+    measureMap(workload, rowHash1K);
+    RowHashContainer<int, int> rowHash8K(8192);
+    measureMap(workload, rowHash8K);
+    RowHashContainer<int, int> rowHash8KLinear(8192, false);
+    measureMap(workload, rowHash8KLinear);
+    //negative lookups short-circuited by a Bloom filter in front of the table
+    BloomFilterContainer<int, int> bloomHopscotch;
+    measureMap(workload, bloomHopscotch);
+    BloomFilterContainer<int, int> bloomHopscotch16(16);
+    measureMap(workload, bloomHopscotch16);
+    BloomFilterContainer<int, int, MapContainer<int, int>> bloomMap;
+    measureMap(workload, bloomMap);
+    //persisted table queried in place: rebuild once, then reopen via mmap
+    HopscotchSnapshotContainer<int, int> snapshot(
+        (std::filesystem::temp_directory_path() / "hashmemcpu-hopscotch.snapshot").string());
+    measureMap(workload, snapshot);
+    //memory-constrained: key remainders and values only
+    CompactCuckooContainer<int, int> compactCuckoo;
+    measureMap(workload, compactCuckoo);
+    //shared table across threads
+    ConcurrentHopscotchContainer<int, int> concurrentHopscotch;
+    measureMap(workload, concurrentHopscotch);
+    const pair<unsigned, unsigned> threadMixes[] = {{0, 1}, {1, 1}, {3, 1}, {2, 2}, {4, 4}};
+    for (const auto& mix : threadMixes) {
+        ConcurrentHopscotchContainer<int, int> sharedHopscotch;
+        measureConcurrentMap(workload, sharedHopscotch, mix.first, mix.second);
+    }
+    LockFreeHashContainer<int, int> lockFree;
+    measureMap(workload, lockFree);
+    for (const auto& mix : threadMixes) {
+        LockFreeHashContainer<int, int> sharedLockFree;
+        measureConcurrentMap(workload, sharedLockFree, mix.first, mix.second);
+    }
+    //hopscotch build and rehash spread over the hardware threads
+    measureBulkBuild(workload);
+    checkRehashRollback(workload);
+    //thread scaling of the shared tables up to the memory bandwidth ceiling
+    measureScalability<ConcurrentHopscotchContainer<int, int>>(workload);
+    measureScalability<LockFreeHashContainer<int, int>>(workload);
+    //message passing to shard owners against the shared tables above
+    ShardedMapContainer<int, int> shardedMap;
+    measureMap(workload, shardedMap);
+    for (unsigned threads : scalingThreadCounts()) {
+        for (size_t batchSize : {1, 64})
+            measureShardedMap(workload, threads, threads, batchSize);
+    }
+    //read-mostly tables: RCU snapshots against a reader-writer lock
+    RcuMapContainer<int, int> rcuMap;
+    measureMap(workload, rcuMap);
+    measureReadMostly<RcuMapContainer<int, int>>(workload);
+    measureReadMostly<SharedMutexContainer<int, int>>(workload);
+    //coroutine-interleaved lookups by number of lookups in flight
+    measureInterleaving<tsl::hopscotch_map<int, int>>(workload, "HopscotchMap");
+    measureInterleaving<std::unordered_map<int, int>>(workload, "UnorderedMap");
+    measureInterleaving<std::map<int, int>>(workload, "Map");
+    //ordered containers only: cost of range queries
+    for (int rangeLength : {16, 256}) {
+        measureRangeScan(workload, map, rangeLength);
+        measureRangeScan(workload, bPlusTree, rangeLength);
+        measureRangeScan(workload, pageBPlusTree, rangeLength);
+        measureRangeScan(workload, art, rangeLength);
+    }
     return 0;
 }